@@ -0,0 +1,50 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures a rule of 16 keywords where the last one is the most common:
+// operator| tries them in source order, lm::adapt_ picks the only
+// keyword that can match from the next byte and learns the order, and
+// lm::reorder_ freezes that order into a plain alternative.
+//
+// Build with `make bench` and run ./adapt_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+auto keywords() {
+    return lit_("ACK") | lit_("BIND") | lit_("CANCEL") | lit_("DATA") | lit_("ECHO") | lit_("FETCH") | lit_("HELLO") | lit_("INFO")
+         | lit_("JOIN") | lit_("KICK") | lit_("LIST") | lit_("MOVE") | lit_("NOTIFY") | lit_("OPEN") | lit_("PING") | lit_("GET");
+}
+
+template <typename Parser>
+void run(const char* label, std::string const& input, Parser const& parser) {
+    const int rounds = 10;
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = parse(input, *parser >> end_, nosk) && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-12s %8.1f MB/s%s\n", label, input.size() * rounds / seconds / 1e6, ok ? "" : " (failed)");
+}
+
+}
+
+int main() {
+    std::string input;
+    for (int i = 0; i < 1000000; ++i)
+        input += i % 10 ? "GET" : i % 20 ? "PING" : "ACK";
+
+    branch_order<16> learned;
+    run("operator|", input, keywords());
+    run("adapt_", input, adapt_(keywords(), learned));
+    std::printf("learned order:");
+    for (std::size_t i : learned.order())
+        std::printf(" %zu", i);
+    std::printf("\n");
+    run("reorder_", input, reorder_<15, 14, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13>(keywords()));
+}
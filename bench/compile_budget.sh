@@ -0,0 +1,123 @@
+#!/bin/sh
+# Compile-time budget for generated grammars.
+#
+# Compiles grammars of increasing size in four shapes and checks each
+# against the limits in compile_budget.txt:
+#
+#     seq N    one rule, a sequence of N parsers
+#     alt N    one rule, an alternative of N literals
+#     nest N   one rule, N levels of ( ... ) nested inside each other
+#     rules N  N rules, each a short sequence and alternative of its own type
+#
+# For each it reports the best of three compile times at CXXFLAGS, the
+# size of that object, and the number of template instantiations.  The
+# instantiations are counted as the weak symbols of an -O0 build, where
+# nothing is inlined away.  Exits with 1 if anything is over budget, so
+# `make compile-bench` fails when a change makes grammars slow to build.
+#
+#     bench/compile_budget.sh                # the limn.h in this repo
+#     bench/compile_budget.sh /tmp/old       # /tmp/old/limn.h
+#
+# CXX and CXXFLAGS are honored (defaults: g++, -std=c++17 -O2).  The
+# budget has headroom for slower machines, but the counts and sizes
+# depend on the compiler; BUDGET names another budget file.
+
+HERE=$(dirname "$0")
+INCLUDE=${1:-$HERE/..}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+BUDGET=${BUDGET:-$HERE/compile_budget.txt}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# the i-th lower case letter, as a char literal
+letter() {
+    printf "'%s'" "$(printf '\\%03o' $((97 + $1 % 26)))"
+}
+
+generate() {
+    shape=$1
+    n=$2
+    echo '#include "limn.h"'
+    echo 'using namespace lm;'
+    case $shape in
+    seq)
+        printf 'bool rule(std::string_view sv) {\n    return parse(sv, char_(%s)' "$(letter 0)"
+        i=1
+        while [ $i -lt "$n" ]; do
+            printf ' >> char_(%s)' "$(letter $i)"
+            i=$((i + 1))
+        done
+        printf ' >> end_);\n}\n'
+        ;;
+    alt)
+        printf 'bool rule(std::string_view sv) {\n    return parse(sv, (lit_("x0")'
+        i=1
+        while [ $i -lt "$n" ]; do
+            printf ' | lit_("x%d")' $i
+            i=$((i + 1))
+        done
+        printf ') >> end_);\n}\n'
+        ;;
+    nest)
+        expr="char_('x')"
+        i=0
+        while [ $i -lt "$n" ]; do
+            expr="(char_('(') >> ($expr) >> char_(')')) | char_($(letter $i))"
+            i=$((i + 1))
+        done
+        printf 'bool rule(std::string_view sv) {\n    return parse(sv, (%s) >> end_);\n}\n' "$expr"
+        ;;
+    rules)
+        # every rule has its own types, so the instantiations grow with N
+        r=0
+        while [ $r -lt "$n" ]; do
+            printf 'bool rule%d(std::string_view sv) {\n    return parse(sv, lit_("r%d")' $r $r
+            i=0
+            while [ $i -le $((r % 4)) ]; do
+                printf ' >> char_(%s)' "$(letter $((r + i)))"
+                i=$((i + 1))
+            done
+            printf ' >> repeat_<%d>(digit_) >> (lit_("a") | lit_("b%d") | char_(%s)) >> end_);\n}\n' \
+                $((r + 1)) $r "$(letter $((r + 1)))"
+            r=$((r + 1))
+        done
+        ;;
+    esac
+}
+
+# over <value> <limit>: true if value is over a set limit
+over() {
+    [ -n "$2" ] && awk -v v="$1" -v l="$2" 'BEGIN { exit !(v > l) }'
+}
+
+failed=0
+printf '%-6s %-5s %-16s %-22s %-22s\n' shape n seconds instantiations bytes
+while read -r shape n seconds_max count_max bytes_max; do
+    case $shape in ''|'#'*) continue ;; esac
+    src="$WORK/$shape$n.cpp"
+    obj="$WORK/$shape$n.o"
+    generate "$shape" "$n" > "$src"
+
+    $CXX -std=c++17 -O0 -I"$INCLUDE" -c "$src" -o "$obj" || exit 1
+    count=$(nm "$obj" | grep -c ' [WVu] ')
+
+    best=
+    for attempt in 1 2 3; do
+        start=$(date +%s.%N)
+        $CXX $CXXFLAGS -I"$INCLUDE" -c "$src" -o "$obj" || exit 1
+        stop=$(date +%s.%N)
+        best=$(awk -v a="$start" -v b="$stop" -v best="$best" 'BEGIN { t = b - a; print (best == "" || t < best) ? t : best }')
+    done
+    bytes=$(wc -c < "$obj")
+
+    status=
+    if over "$best" "$seconds_max"; then status="$status seconds"; fi
+    if over "$count" "$count_max"; then status="$status instantiations"; fi
+    if over "$bytes" "$bytes_max"; then status="$status bytes"; fi
+    printf '%-6s %-5s %-16s %-22s %-22s%s\n' "$shape" "$n" \
+        "$(printf '%.2f/%s' "$best" "$seconds_max")" "$count/$count_max" "$bytes/$bytes_max" \
+        "${status:+  OVER BUDGET:$status}"
+    if [ -n "$status" ]; then failed=1; fi
+done < "$BUDGET"
+exit $failed
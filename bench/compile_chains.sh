@@ -0,0 +1,55 @@
+#!/bin/sh
+# Compile-time benchmark for long seq_/alt_ chains.
+#
+# Generates translation units with RULES rules, each a sequence of LEN
+# parsers and an alternative of LEN literals, and reports the best of
+# three compile times and the object size.  Pass a directory holding
+# another limn.h to compare against it, for example an older checkout:
+#
+#     bench/compile_chains.sh              # the limn.h in this repo
+#     bench/compile_chains.sh /tmp/old     # /tmp/old/limn.h
+#
+# CXX and CXXFLAGS are honored (defaults: g++, -std=c++17 -O2).
+
+INCLUDE=${1:-$(dirname "$0")/..}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+RULES=${RULES:-20}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+generate() {
+    len=$1
+    echo '#include "limn.h"'
+    echo 'using namespace lm;'
+    r=0
+    while [ $r -lt "$RULES" ]; do
+        printf 'bool rule%d(std::string_view sv) {\n    return parse(sv, lit_("r%d")' $r $r
+        i=0
+        while [ $i -lt "$len" ]; do
+            printf ' >> char_(%s)' "'$(printf '\\%03o' $((97 + i % 26)))'"
+            i=$((i + 1))
+        done
+        printf ' >> (lit_("x0")'
+        i=1
+        while [ $i -lt "$len" ]; do
+            printf ' | lit_("x%d")' $i
+            i=$((i + 1))
+        done
+        printf ') >> end_);\n}\n'
+        r=$((r + 1))
+    done
+}
+
+printf '%-6s %-10s %-10s\n' length seconds bytes
+for len in 8 16 32 64; do
+    generate $len > "$WORK/chain$len.cpp"
+    best=
+    for attempt in 1 2 3; do
+        start=$(date +%s.%N)
+        $CXX $CXXFLAGS -I"$INCLUDE" -c "$WORK/chain$len.cpp" -o "$WORK/chain$len.o" || exit 1
+        stop=$(date +%s.%N)
+        best=$(awk -v a="$start" -v b="$stop" -v best="$best" 'BEGIN { t = b - a; print (best == "" || t < best) ? t : best }')
+    done
+    printf '%-6s %-10.2f %-10s\n' $len "$best" "$(wc -c < "$WORK/chain$len.o")"
+done
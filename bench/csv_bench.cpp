@@ -0,0 +1,77 @@
+#include "limn_csv.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures reading a CSV file: a Limn grammar with callbacks that build
+// rows of std::string, against lm::csv::reader, which indexes the
+// delimiters with SIMD and fills columns of offsets.
+//
+// Build with `make bench` and run ./csv_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeInput(int rows) {
+    std::string input = "id,name,city,amount,comment\n";
+    const char* cities[] = { "Oslo", "Lima", "\"Washington, D.C.\"", "Kyoto" };
+    for (int i = 0; i < rows; ++i) {
+        input += std::to_string(i) + ",user" + std::to_string(i * 7 % 1000) + "," + cities[i % 4] + ",";
+        input += std::to_string(i % 9973) + "." + std::to_string(i % 100) + ",";
+        input += (i % 5) ? "no comment" : "\"said \"\"hello\"\", then left\"";
+        input += "\n";
+    }
+    return input;
+}
+
+template <typename Read>
+void run(const char* label, std::string const& input, Read&& read) {
+    const int rounds = 10;
+    std::size_t rows = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        rows = read(input);
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-32s %8.1f MB/s (%zu rows)\n", label, input.size() * rounds / seconds / 1e6, rows);
+}
+
+}
+
+int main() {
+    const std::string input = makeInput(300000);
+
+    run("grammar, rows of strings", input, [](std::string const& text) {
+        std::vector<std::vector<std::string>> rows;
+        std::vector<std::string> row;
+        auto cell = [&](std::string_view sv) { row.emplace_back(sv); };
+        auto end_row = [&](std::string_view) { rows.push_back(std::move(row)); row.clear(); };
+        auto quoted = char_('"') >> *(lit_("\"\"") | !char_('"')) >> char_('"');
+        auto field = (quoted | *!charset_(",\n"))[cell];
+        auto line = (field % char_(',') >> char_('\n'))[end_row];
+        parse(text, *line >> end_, nosk);
+        return rows.size() - 1;
+    });
+
+    csv::reader reader(csv::dialect{ ',', '"', true });
+    run("csv::reader, 1 thread", input, [&](std::string const& text) {
+        csv::table table;
+        reader.read(text, table);
+        return table.rows();
+    });
+
+    const unsigned threads = std::thread::hardware_concurrency();
+    if (threads > 1) {
+        reader.threads(threads);
+        run("csv::reader, all threads", input, [&](std::string const& text) {
+            csv::table table;
+            reader.read(text, table);
+            return table.rows();
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Measures routing messages to one of 16 grammars: trying them one after
+// another with ||, against lm::dispatcher_, which only tries the grammars
+// that can start with the message's first byte.
+//
+// Build with `make bench` and run ./dispatch_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+const char* const kinds[] = {
+    "ACK", "BIND", "CANCEL", "DATA", "ECHO", "FETCH", "GET", "HELLO",
+    "INFO", "JOIN", "KICK", "LIST", "MOVE", "NOTIFY", "OPEN", "PING",
+};
+
+std::vector<std::string> makeMessages(int count) {
+    std::vector<std::string> messages;
+    for (int i = 0; i < count; ++i)
+        messages.push_back(std::string(kinds[(i * 7) % 16]) + " id=" + std::to_string(i) + " from=node" + std::to_string(i % 13));
+    return messages;
+}
+
+template <typename Route>
+void run(const char* label, std::vector<std::string> const& messages, Route&& route) {
+    const int rounds = 20;
+    std::size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        for (std::string const& message : messages)
+            sum += route(message);
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-16s %8.1f M messages/s (%zu)\n", label, messages.size() * rounds / seconds / 1e6, sum);
+}
+
+}
+
+int main() {
+    const std::vector<std::string> messages = makeMessages(100000);
+    auto const fields = *(lexeme_(+alpha_) >> char_('=') >> lexeme_(+alnum_)) >> end_;
+    auto const g = [&](const char* kind) { return lit_(kind) >> fields; };
+
+    auto const g0 = g(kinds[0]), g1 = g(kinds[1]), g2 = g(kinds[2]), g3 = g(kinds[3]);
+    auto const g4 = g(kinds[4]), g5 = g(kinds[5]), g6 = g(kinds[6]), g7 = g(kinds[7]);
+    auto const g8 = g(kinds[8]), g9 = g(kinds[9]), g10 = g(kinds[10]), g11 = g(kinds[11]);
+    auto const g12 = g(kinds[12]), g13 = g(kinds[13]), g14 = g(kinds[14]), g15 = g(kinds[15]);
+
+    run("||", messages, [&](std::string const& m) -> std::size_t {
+        std::size_t i = 0;
+        (void)(parse(m, g0) || (++i, parse(m, g1)) || (++i, parse(m, g2)) || (++i, parse(m, g3))
+            || (++i, parse(m, g4)) || (++i, parse(m, g5)) || (++i, parse(m, g6)) || (++i, parse(m, g7))
+            || (++i, parse(m, g8)) || (++i, parse(m, g9)) || (++i, parse(m, g10)) || (++i, parse(m, g11))
+            || (++i, parse(m, g12)) || (++i, parse(m, g13)) || (++i, parse(m, g14)) || (++i, parse(m, g15)));
+        return i;
+    });
+
+    dispatcher_ const route(g0, g1, g2, g3, g4, g5, g6, g7, g8, g9, g10, g11, g12, g13, g14, g15);
+    run("dispatcher_", messages, [&](std::string const& m) { return route.parse(m); });
+}
@@ -0,0 +1,83 @@
+#include "limn_json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Measures JSON throughput on the usual corpus shapes: deeply nested
+// arrays and objects, number-heavy (like canada.json), string-heavy
+// (like twitter.json) and a mix.  Track these MB/s across changes.
+//
+// Build with `make bench` and run ./json_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string nested(int documents) {
+    std::string input = "[";
+    for (int d = 0; d < documents; ++d) {
+        if (d)
+            input += ",";
+        for (int i = 0; i < 40; ++i)
+            input += (i % 2) ? "{\"k\":" : "[";
+        input += "0";
+        for (int i = 39; i >= 0; --i)
+            input += (i % 2) ? "}" : "]";
+    }
+    return input + "]";
+}
+
+std::string numbers(int points) {
+    std::string input = "{\"type\":\"Polygon\",\"coordinates\":[";
+    for (int i = 0; i < points; ++i) {
+        if (i)
+            input += ",";
+        input += "[-" + std::to_string(65 + i % 10) + "." + std::to_string(100000 + i * 7919LL % 900000)
+            + "," + std::to_string(43 + i % 7) + "." + std::to_string(100000 + i * 104729LL % 900000) + "e0]";
+    }
+    return input + "]}";
+}
+
+std::string strings(int tweets) {
+    std::string input = "{\"statuses\":[";
+    for (int i = 0; i < tweets; ++i) {
+        if (i)
+            input += ",";
+        input += "{\"id\":" + std::to_string(1000000 + i) + ",\"user\":\"user_" + std::to_string(i % 97) + "\","
+            "\"text\":\"RT @someone: this is a fairly ordinary tweet with some words in it, number "
+            + std::to_string(i) + " \\u2014 and a link https:\\/\\/example.com\\/" + std::to_string(i) + "\","
+            "\"lang\":\"en\",\"retweeted\":false,\"place\":null}";
+    }
+    return input + "]}";
+}
+
+void run(const char* label, std::string const& input) {
+    const int rounds = 20;
+    std::vector<json::value> values(input.size() + 16);
+    json::tape tape(values.data(), values.size());
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = json::parse(input, tape) == json::result::ok && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-14s tape  %8.1f MB/s (%zu values, %s)\n", label, input.size() * rounds / seconds / 1e6, tape.size(), ok ? "ok" : "FAILED");
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = json::valid(input) && ok;
+    stop = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-14s valid %8.1f MB/s (%s)\n", label, input.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+}
+
+}
+
+int main() {
+    run("nested", nested(20000));
+    run("number-heavy", numbers(100000));
+    run("string-heavy", strings(20000));
+    return 0;
+}
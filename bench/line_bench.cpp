@@ -0,0 +1,65 @@
+#include "limn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Measures finding the line and column of error offsets: counting the
+// newlines from the start of the input for every lookup, against one
+// lm::line_index that indexes the newlines at the first lookup.
+//
+// Build with `make bench` and run ./line_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeInput(int lines) {
+    std::string input;
+    for (int i = 0; i < lines; ++i)
+        input += "    let value_" + std::to_string(i) + " = compute(" + std::to_string(i % 97) + ", \"text\");\n";
+    return input;
+}
+
+template <typename Lookup>
+void run(const char* label, std::string const& input, std::vector<std::size_t> const& offsets, Lookup&& lookup) {
+    const int rounds = 5;
+    std::size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        sum += lookup(input, offsets);
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-26s %10.1f us per round (%zu)\n", label, seconds / rounds * 1e6, sum);
+}
+
+}
+
+int main() {
+    const std::string input = makeInput(200000);
+    std::vector<std::size_t> offsets;
+    for (std::size_t i = 0; i < 100; ++i)
+        offsets.push_back(i * 7919 * 131 % input.size());
+
+    run("count from the start", input, offsets, [](std::string const& text, std::vector<std::size_t> const& at) {
+        std::size_t sum = 0;
+        for (std::size_t offset : at)
+            sum += 1 + static_cast<std::size_t>(std::count(text.begin(), text.begin() + static_cast<std::ptrdiff_t>(offset), '\n'));
+        return sum;
+    });
+
+    run("line_index", input, offsets, [](std::string const& text, std::vector<std::size_t> const& at) {
+        line_index lines(text);
+        std::size_t sum = 0;
+        for (std::size_t offset : at)
+            sum += lines.locate(offset).line;
+        return sum;
+    });
+
+    run("line_index, never asked", input, offsets, [](std::string const& text, std::vector<std::size_t> const&) {
+        line_index lines(text);
+        return lines.source.size() != 0 ? std::size_t(0) : std::size_t(1);
+    });
+}
@@ -0,0 +1,70 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures literal matching: a block of HTTP-style header lines where
+// each line tries a list of header names in order.  The names are 4 to
+// 16 bytes, the range where lit_ compares whole words.
+//
+// Build with `make bench` and run ./lit_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeInput(int lines, bool shout) {
+    const char* names[] = { "Host", "User-Agent", "Accept", "Accept-Encoding", "Content-Length", "Connection", "Cache-Control" };
+    const char* upper[] = { "HOST", "USER-AGENT", "ACCEPT", "ACCEPT-ENCODING", "CONTENT-LENGTH", "CONNECTION", "CACHE-CONTROL" };
+    std::string input;
+    for (int i = 0; i < lines; ++i) {
+        input += (shout ? upper : names)[(i * 5) % 7];
+        input += ": value" + std::to_string(i) + "\r\n";
+    }
+    return input;
+}
+
+template <typename Name>
+double run(const char* label, std::string const& input, Name const& name) {
+    constexpr auto value = +!char_('\r');
+    auto document = *(name >> lit_(": ") >> value >> lit_("\r\n")) >> end_;
+
+    const int rounds = 200;
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = parse(input, document, nosk) && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-28s %8.1f MB/s (%s)\n", label, input.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+    return seconds;
+}
+
+}
+
+int main() {
+    const std::string input = makeInput(20000, false);
+    const std::string shouted = makeInput(20000, true);
+
+    // built at compile time, the compiler knows every literal
+    static constexpr auto fixed = lit_("Host") | lit_("User-Agent") | lit_("Accept-Encoding") | lit_("Accept")
+        | lit_("Content-Length") | lit_("Connection") | lit_("Cache-Control");
+    run("lit_, constexpr grammar", input, fixed);
+
+    // built at run time from data, as when names come from a config file
+    std::string names[] = { "Host", "User-Agent", "Accept-Encoding", "Accept", "Content-Length", "Connection", "Cache-Control" };
+    auto dynamic = lit_(names[0]) | lit_(names[1]) | lit_(names[2]) | lit_(names[3])
+        | lit_(names[4]) | lit_(names[5]) | lit_(names[6]);
+    run("lit_, run time grammar", input, dynamic);
+
+    // the same alternatives merged by optimize, which skips the literals
+    // whose next byte after the shared prefix can't match
+    static constexpr auto merged = optimize(fixed);
+    run("lit_, optimized", input, merged);
+
+    static constexpr auto folded = ilit_("host") | ilit_("user-agent") | ilit_("accept-encoding") | ilit_("accept")
+        | ilit_("content-length") | ilit_("connection") | ilit_("cache-control");
+    run("ilit_, constexpr grammar", shouted, folded);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures parsing lists of numbers and words from a plain string_view,
+// which checks for the end of the input at every byte, against
+// lm::padded input, which reads ahead into zero padding instead.
+//
+// Build with `make bench` and run ./padded_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeInput(int items) {
+    std::string input;
+    for (int i = 0; i < items; ++i)
+        input += std::to_string(1000003LL * i) + (i % 3 ? " value_" : " key_") + std::to_string(i % 17) + ",";
+    return input;
+}
+
+template <typename Parse>
+void run(const char* label, std::size_t size, Parse&& parse_once) {
+    const int rounds = 50;
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = parse_once() && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-14s %8.1f MB/s%s\n", label, size * rounds / seconds / 1e6, ok ? "" : " (failed)");
+}
+
+}
+
+int main() {
+    std::string input = makeInput(200000);
+    const std::size_t size = input.size();
+    input.append(padding, '\0');
+    const std::string_view text(input.data(), size);
+
+    auto const item = lexeme_(+digit_) >> char_(' ') >> lexeme_(+range_('a', 'z') >> char_('_') >> +digit_) >> char_(',');
+    auto const grammar = *item >> end_;
+
+    run("string_view", size, [&] { return parse(text, grammar, nosk); });
+    run("padded", size, [&] { return parse(padded(text), grammar, nosk); });
+}
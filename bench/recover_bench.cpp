@@ -0,0 +1,71 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Measures finding the good and bad records of a buffer with one bad
+// record three quarters of the way in: parsing the whole buffer, then
+// line by line once that fails, against one pass with lm::recover_.
+//
+// Build with `make bench` and run ./recover_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeRecords(int count) {
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        text += "id=" + std::to_string(i) + ",name=user" + std::to_string(i % 97) + ",score=" + std::to_string(i * 31 % 1000);
+        text += i == count * 3 / 4 ? ",score=n/a\n" : "\n";
+    }
+    return text;
+}
+
+template <typename Run>
+void run(const char* label, std::string const& text, Run&& pass) {
+    const int rounds = 20;
+    std::size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        sum += pass();
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-16s %8.1f MB/s (%zu)\n", label, text.size() * rounds / seconds / 1e6, sum);
+}
+
+}
+
+int main() {
+    const std::string text = makeRecords(200000);
+    auto const field = lexeme_(+alpha_) >> char_('=') >> lexeme_(+alnum_);
+    auto const record = field >> *(char_(',') >> field) >> char_('\n');
+    std::size_t good = 0;
+    auto const counted = record >> action_([&](std::string_view&) { return ++good != 0; });
+
+    run("parse, then lines", text, [&] {
+        std::vector<std::string_view> errors;
+        good = 0;
+        if (!parse(text, *counted >> end_, nosk)) {
+            good = 0;
+            std::string_view rest = text;
+            while (!rest.empty()) {
+                const std::size_t n = rest.find('\n') + 1;
+                if (!parse(rest.substr(0, n), counted >> end_, nosk))
+                    errors.push_back(rest.substr(0, n - 1));
+                rest.remove_prefix(n);
+            }
+        }
+        return good + errors.size();
+    });
+
+    run("recover_", text, [&] {
+        std::vector<std::string_view> errors;
+        good = 0;
+        parse(text, *recover_(counted, char_('\n'), errors) >> end_, nosk);
+        return good + errors.size();
+    });
+}
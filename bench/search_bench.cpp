@@ -0,0 +1,63 @@
+#include "limn.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures searching a log for request lines: calling parse at every
+// offset against lm::find_all, which only tries the grammar where its
+// FIRST byte ('G') appears.
+//
+// Build with `make bench` and run ./search_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+std::string makeInput(int lines) {
+    std::string input;
+    for (int i = 0; i < lines; ++i) {
+        input += "2024-01-01T00:00:" + std::to_string(i % 60) + " worker=" + std::to_string(i % 8);
+        input += (i % 10) ? " status=ok latency=12ms\n" : " GET /api/v1/items/" + std::to_string(i) + " 200\n";
+    }
+    return input;
+}
+
+template <typename Search>
+void run(const char* label, std::string const& input, Search&& search) {
+    const int rounds = 20;
+    std::size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        found = search(input);
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-24s %8.1f MB/s (%zu matches)\n", label, input.size() * rounds / seconds / 1e6, found);
+}
+
+}
+
+int main() {
+    const std::string input = makeInput(100000);
+    auto request = lit_("GET ") >> lexeme_(+graph_);
+
+    run("parse at every offset", input, [&](std::string const& text) {
+        std::size_t found = 0;
+        std::string_view sv = text;
+        while (!sv.empty()) {
+            std::string_view rest = sv;
+            if (request.visit(rest, nosk) && rest.size() != sv.size()) {
+                ++found;
+                sv = rest;
+            } else {
+                sv.remove_prefix(1);
+            }
+        }
+        return found;
+    });
+
+    run("find_all", input, [&](std::string const& text) {
+        return find_all(text, request, [](std::string_view) {});
+    });
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "limn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures whitespace skipping on indentation-heavy input.  Every line
+// is deeply indented and the grammar nests sequences, alternatives,
+// repetitions and captures, which is where redundant skips pile up.
+// Then the same input with comments, parsed with lm::SkipComments against
+// stripping the comments in a separate pass first.
+//
+// Build with `make bench` and run ./skip_bench.out
+
+namespace {
+
+using namespace lm; // Laziness
+
+// counts the calls and the bytes looked at, on top of skipping
+class CountingSkipper : public Skipper
+{
+public:
+    bool skip(std::string_view& sv) noexcept {
+        ++calls;
+        bool remove_char = false;
+        while (!sv.empty() && 0 != std::isspace(sv.front())) {
+            sv.remove_prefix(1);
+            remove_char = true;
+            ++bytes;
+        }
+        if (!sv.empty())
+            ++bytes;
+        return remove_char;
+    }
+
+    unsigned long long calls = 0;
+    unsigned long long bytes = 0;
+};
+
+std::string makeInput(int blocks, int keysPerBlock, int indent) {
+    std::string input;
+    for (int b = 0; b < blocks; ++b) {
+        input += "[section" + std::to_string(b) + "]\n";
+        for (int k = 0; k < keysPerBlock; ++k) {
+            input += std::string(indent, ' ') + "key" + std::to_string(k) + " = ";
+            input += (k % 2) ? "value" + std::to_string(k) : std::to_string(k * 7);
+            input += "\n" + std::string(indent, ' ') + "\t\n";
+        }
+    }
+    return input;
+}
+
+std::string addComments(std::string const& input) {
+    std::string output;
+    std::size_t line = 0;
+    for (char ch : input) {
+        if (ch == '\n' && ++line % 2)
+            output += (line % 4 == 1) ? "  // the value above, with a fairly long explanation of why it is what it is"
+                                      : "  /* a block comment that goes on for a while before it ends */";
+        output += ch;
+    }
+    return output;
+}
+
+// the separate pass that SkipComments replaces
+std::string stripComments(std::string_view input) {
+    std::string output;
+    output.reserve(input.size());
+    while (!input.empty()) {
+        if (input.substr(0, 2) == "//") {
+            input.remove_prefix(std::min(input.size(), input.find('\n')));
+        } else if (input.substr(0, 2) == "/*") {
+            input.remove_prefix(std::min(input.size(), input.find("*/") + 2));
+        } else {
+            output += input.front();
+            input.remove_prefix(1);
+        }
+    }
+    return output;
+}
+
+}
+
+int main() {
+    std::string_view last;
+    auto capture = [&](const std::string_view& sv) { last = sv; };
+
+    auto ident = lexeme_(alpha_ >> *alnum_);
+    auto number = lexeme_(+digit_);
+    auto value = (ident | number)[capture];
+    auto entry = ident >> char_('=') >> value;
+    auto section = char_('[') >> ident >> char_(']') >> *(entry >> opt_(char_(';')));
+    auto document = *section >> end_;
+
+    const std::string input = makeInput(200, 50, 24);
+    const int rounds = 50;
+
+    CountingSkipper counter;
+    if (!parse(input, document, counter)) {
+        std::printf("parse failed\n");
+        return 1;
+    }
+    std::printf("input: %zu bytes\n", input.size());
+    std::printf("skip calls per parse: %llu\n", counter.calls);
+    std::printf("bytes examined by skipper per parse: %llu\n", counter.bytes);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (int i = 0; i < rounds; ++i)
+        ok = parse(input, document) && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("throughput: %.1f MB/s (%s)\n", input.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+
+    const std::string commented = addComments(input);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = parse(stripComments(commented), document) && ok;
+    stop = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("strip comments, then parse: %.1f MB/s (%s)\n", commented.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = parse(commented, document, skcomments) && ok;
+    stop = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("parse with SkipComments: %.1f MB/s (%s)\n", commented.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include "limn_utf8.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Measures UTF-8 validation on mixed text (mostly ASCII with Greek,
+// CJK and emoji) with the SIMD validator against decoding each code
+// point.
+//
+// Build with `make bench` and run ./utf8_bench.out
+
+namespace {
+
+template <typename Check>
+void run(const char* label, std::string const& input, Check&& check) {
+    const int rounds = 200;
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        ok = check(input) && ok;
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::printf("%-24s %8.1f MB/s (%s)\n", label, input.size() * rounds / seconds / 1e6, ok ? "ok" : "FAILED");
+}
+
+}
+
+int main() {
+    std::string input;
+    for (int i = 0; i < 20000; ++i)
+        input += (i % 4) ? "plain ascii words, " : "κόσμε 世界 🎉 naïve, ";
+
+    run("utf8_valid", input, [](std::string const& s) { return lm::utf8_valid(s); });
+    run("decode each code point", input, [](std::string const& s) {
+        return lm::parse(s, *lm::u8char_() >> lm::end_, lm::nosk);
+    });
+    return 0;
+}
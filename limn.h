@@ -6,14 +6,25 @@
 #pragma once
 
 #include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <string_view>
 #include <functional> // support match function call
+#include <tuple>
+#include <type_traits>
+#include <vector> // deferred callbacks past the inline buffer, line_index
 
 #ifndef _MSC_VER
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wshadow"
 #endif
 
+#ifdef _MSC_VER
+#define LIMN_NOINLINE __declspec(noinline)
+#else
+#define LIMN_NOINLINE __attribute__((noinline))
+#endif
+
 /// @namespace lm
 /// @brief The namesapce for all Limn types, functions, and variables
 namespace lm {
@@ -51,12 +62,629 @@ namespace lm {
         };
     };
 
+    /// @class SkipComments
+    /// @brief Skips whitespace and comments
+    /// @details By default the comments are C and C++ ones, `// ...` up to
+    ///     the end of the line and `/* ... */`.  Other languages pass their
+    ///     own delimiters, for example `SkipComments("#", "", "")` for
+    ///     shell scripts or `SkipComments("--", "{-", "-}")` for Haskell.
+    ///     An empty delimiter turns that kind of comment off.  Block
+    ///     comments don't nest, and one without its end isn't skipped, so
+    ///     the parse fails there.
+    ///
+    ///     The ends of comments are found with memchr, which the C library
+    ///     vectorizes, so a long comment costs about as much as a copy.
+    class SkipComments : public Skipper
+    {
+    public:
+        /// @param[in] line Starts a comment that ends at the next newline
+        /// @param[in] open Starts a block comment
+        /// @param[in] close Ends a block comment
+        constexpr SkipComments(std::string_view line = "//", std::string_view open = "/*", std::string_view close = "*/") noexcept
+            : line(line)
+            , open(open)
+            , close(close)
+        {}
+
+        /// call the skip function when we run the visit()
+        bool skip(std::string_view& sv) noexcept {
+            const std::size_t size = sv.size();
+            for (;;) {
+                while (!sv.empty() && 0 != std::isspace(sv.front())) {
+                    sv.remove_prefix(1);
+                }
+                if (!line.empty() && starts_with(sv, line)) {
+                    void const* nl = std::memchr(sv.data() + line.size(), '\n', sv.size() - line.size());
+                    sv.remove_prefix(nl ? static_cast<std::size_t>(static_cast<char const*>(nl) - sv.data()) + 1 : sv.size());
+                } else if (!open.empty() && !close.empty() && starts_with(sv, open)) {
+                    const std::size_t end = find_close(sv);
+                    if (end == std::string_view::npos) {
+                        break;
+                    }
+                    sv.remove_prefix(end + close.size());
+                } else {
+                    break;
+                }
+            }
+            return sv.size() != size;
+        }
+
+    private:
+        static bool starts_with(std::string_view sv, std::string_view prefix) noexcept {
+            return sv.size() >= prefix.size() && 0 == std::memcmp(sv.data(), prefix.data(), prefix.size());
+        }
+
+        // offset of the close delimiter after the open one, or npos
+        std::size_t find_close(std::string_view sv) const noexcept {
+            char const* const last = sv.data() + sv.size();
+            char const* p = sv.data() + open.size();
+            while (static_cast<std::size_t>(last - p) >= close.size()) {
+                void const* hit = std::memchr(p, close.front(), static_cast<std::size_t>(last - p) - close.size() + 1);
+                if (!hit) {
+                    break;
+                }
+                p = static_cast<char const*>(hit);
+                if (0 == std::memcmp(p, close.data(), close.size())) {
+                    return static_cast<std::size_t>(p - sv.data());
+                }
+                ++p;
+            }
+            return std::string_view::npos;
+        }
+
+        std::string_view line;
+        std::string_view open;
+        std::string_view close;
+    };
+
     static SkipWhitespace skws;
     static NoSkip nosk;
+    static SkipComments skcomments;
+
+    /// @struct token
+    /// @brief One token produced by `lm::lexer_`
+    /// @details Tokens refer back into the source text by offset so that a
+    ///     token array stays compact.  Inputs are limited to 4GB.
+    struct token {
+        std::uint32_t offset;
+        std::uint32_t length;
+        std::uint16_t kind;
+    };
+
+    /// @class token_stream
+    /// @brief Parser input over an array of tokens
+    /// @details A token_stream is to `lm::tok_` and `lm::kw_` what a
+    ///     `std::string_view` is to the character parsers.  The combinators
+    ///     accept either kind of input.  Rewinding a token_stream only
+    ///     costs a pointer copy, so backtracking never re-lexes anything.
+    struct token_stream {
+        constexpr token_stream(std::string_view source, token const* first, token const* last) noexcept
+            : source(source)
+            , first(first)
+            , last(last)
+        {}
+
+        constexpr bool empty() const noexcept { return first == last; }
+        constexpr std::size_t size() const noexcept { return static_cast<std::size_t>(last - first); }
+        constexpr token const& front() const noexcept { return *first; }
+        constexpr void remove_prefix(std::size_t n) noexcept { first += n; }
+
+        /// @brief The source text of \p tok
+        constexpr std::string_view text(token const& tok) const noexcept {
+            return source.substr(tok.offset, tok.length);
+        }
+
+        constexpr bool operator==(token_stream const& other) const noexcept { return first == other.first && last == other.last; }
+        constexpr bool operator!=(token_stream const& other) const noexcept { return !(*this == other); }
+
+        std::string_view source;
+        token const* first;
+        token const* last;
+    };
+
+    namespace impl {
+        struct capture_access;
+    }
+
+    /// @struct capture
+    /// @brief One span recorded by `lm::capture_`
+    /// @details Like tokens, captures refer to the input by offset.
+    struct capture {
+        std::uint32_t tag;
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    /// @class capture_buffer
+    /// @brief Caller-provided storage for the captures of a parse
+    /// @details Holds every span that an `lm::capture_` matched, in the
+    ///     order the captures started (outer before inner).  The buffer
+    ///     never allocates; see `lm::parse(input, parser, captures)`.
+    class capture_buffer {
+    public:
+        /// @param[out] data The array that receives the captures
+        /// @param[in] capacity The size of \p data
+        constexpr capture_buffer(capture* data, std::size_t capacity) noexcept
+            : data(data)
+            , capacity(capacity)
+        {}
+
+        template <std::size_t N>
+        constexpr explicit capture_buffer(capture (&data)[N]) noexcept
+            : capture_buffer(data, N)
+        {}
+
+        /// @brief The number of captures stored
+        constexpr std::size_t size() const noexcept { return count < capacity ? count : capacity; }
+        constexpr bool empty() const noexcept { return count == 0; }
+        /// @brief True if the last parse made more captures than fit.  size()
+        ///     is then the capacity and needed() says how many there were.
+        constexpr bool overflow() const noexcept { return count > capacity; }
+        constexpr std::size_t needed() const noexcept { return count; }
+        constexpr capture const* begin() const noexcept { return data; }
+        constexpr capture const* end() const noexcept { return data + size(); }
+        constexpr capture const& operator[](std::size_t i) const noexcept { return data[i]; }
+
+        /// @brief The input text of \p cap
+        constexpr std::string_view text(capture const& cap) const noexcept {
+            return source.substr(cap.begin, cap.end - cap.begin);
+        }
+
+        /// @brief The input of the last parse
+        std::string_view source;
+
+    private:
+        friend struct impl::capture_access;
+
+        capture* data;
+        std::size_t capacity;
+        std::size_t count = 0;
+    };
+
+    /// @struct rule_info
+    /// @brief The parser that a tracer event is about
+    /// @details \p id is the address of the parser object, so two uses of
+    ///     the same combinator are told apart.  A first child can share its
+    ///     parent's address, so a rule is \p id together with \p type, which
+    ///     is different for every parser type.  \p name is the type without
+    ///     namespaces or template arguments, like "seq_" or "char_".
+    struct rule_info {
+        void const* id;
+        void const* type;
+        std::string_view name;
+    };
+
+    /// @brief The result of a parse with `lm::limits`
+    enum class parse_result {
+        matched,
+        no_match,
+        out_of_steps, ///< the step budget ran out first
+        too_deep,     ///< the parsers nested deeper than allowed
+    };
+
+    /// @var padding
+    /// @brief How many zero bytes `lm::padded` input has after its end
+    constexpr std::size_t padding = 16;
+
+    /// @struct padded
+    /// @brief Input followed by at least `lm::padding` readable zero bytes
+    /// @details Many I/O buffers already have room after the data.  When
+    ///     the input says so, the repetitions of character classes and the
+    ///     literals read ahead without checking for the end of the input
+    ///     at every byte, and read a word at a time without a scalar tail:
+    ///
+    ///         buffer.resize(size + lm::padding); // zero filled
+    ///         lm::parse(lm::padded(std::string_view(buffer.data(), size)), grammar);
+    ///
+    ///     The bytes of the padding must be zero, and stay so for the parse.
+    struct padded {
+        constexpr explicit padded(std::string_view text) noexcept
+            : text(text)
+        {}
+
+        std::string_view text;
+    };
+
+    /// @struct limits
+    /// @brief Bounds on the work of one parse, for untrusted input
+    /// @details A step is one visit of a parser in the grammar, so
+    ///     backtracking spends steps each time it retries.  The depth is
+    ///     how many visits are nested, which bounds the stack that
+    ///     recursive rules can use.
+    struct limits {
+        std::size_t steps = static_cast<std::size_t>(-1);
+        std::size_t depth = 1000;
+    };
 
 
     namespace impl {
 
+        // Input that records captures.  The number of captures so far is
+        // part of the input state, so every combinator that rewinds the
+        // input (sv = save) also drops the captures made since, and the
+        // character parsers see a plain string_view.
+        struct capture_view : std::string_view {
+            constexpr capture_view(std::string_view sv, capture_buffer* buffer) noexcept
+                : std::string_view(sv)
+                , buffer(buffer)
+            {}
+
+            capture_buffer* buffer;
+            std::size_t count = 0;
+        };
+
+        struct capture_access {
+            // store cap as capture number index, if it fits
+            static constexpr void store(capture_buffer& b, std::size_t index, capture const& cap) noexcept {
+                if (index < b.capacity) {
+                    b.data[index] = cap;
+                }
+            }
+
+            static constexpr void finish(capture_buffer& b, std::string_view source, std::size_t count) noexcept {
+                b.source = source;
+                b.count = count;
+            }
+        };
+
+        // A callback of lm::parse_deferred that waits for the parse to succeed
+        struct deferred_call {
+            std::function<void(const std::string_view&)> const* callback;
+            std::string_view text;
+        };
+
+        // The pending callbacks.  The first ones live in the log itself,
+        // so most parses never allocate
+        class action_log {
+        public:
+            void put(std::size_t index, deferred_call const& call) {
+                if (index < inline_size) {
+                    local[index] = call;
+                } else if (index - inline_size < spill.size()) {
+                    spill[index - inline_size] = call;
+                } else {
+                    spill.push_back(call);
+                }
+            }
+
+            // the first count callbacks, in the order they were logged
+            void run(std::size_t count) const {
+                for (std::size_t i = 0; i < count; ++i) {
+                    deferred_call const& call = i < inline_size ? local[i] : spill[i - inline_size];
+                    (*call.callback)(call.text);
+                }
+            }
+
+        private:
+            static constexpr std::size_t inline_size = 32;
+
+            deferred_call local[inline_size];
+            std::vector<deferred_call> spill;
+        };
+
+        // Input that logs callbacks instead of running them.  Like
+        // capture_view, the number of callbacks so far is part of the input
+        // state, so rewinding the input drops the ones logged since.
+        struct deferred_view : std::string_view {
+            constexpr deferred_view(std::string_view sv, action_log* log) noexcept
+                : std::string_view(sv)
+                , log(log)
+            {}
+
+            action_log* log;
+            std::size_t count = 0;
+        };
+
+        // The unqualified name of T, without template arguments
+        template <typename T>
+        constexpr std::string_view rule_name() noexcept {
+#ifdef _MSC_VER
+            std::string_view name = __FUNCSIG__;
+            name.remove_prefix(name.find("rule_name<") + 10);
+#else
+            std::string_view name = __PRETTY_FUNCTION__;
+            name.remove_prefix(name.find("T = ") + 4);
+#endif
+            name = name.substr(0, name.find_first_of("<>;]("));
+            const std::size_t scope = name.rfind("::");
+            return scope == std::string_view::npos ? name : name.substr(scope + 2);
+        }
+
+        // one address per type, for rule_info::type
+        template <typename T>
+        struct type_tag {
+            static constexpr char id = 0;
+        };
+
+        // Input that reports every visit to a tracer, see lm::parse_traced.
+        // Only the combinators' visits are hooked, so the character parsers
+        // still see a plain string_view, and parses without a tracer don't
+        // contain any of this.
+        template <typename Tracer>
+        struct traced_view : std::string_view {
+            constexpr traced_view(std::string_view sv, Tracer* tracer) noexcept
+                : std::string_view(sv)
+                , tracer(tracer)
+                , base(sv.data())
+            {}
+
+            template <typename Parser>
+            std::size_t enter(Parser const& parser) const {
+                const std::size_t from = static_cast<std::size_t>(data() - base);
+                tracer->enter(rule_info{ &parser, &type_tag<Parser>::id, impl::rule_name<Parser>() }, from);
+                return from;
+            }
+
+            template <typename Parser>
+            bool leave(Parser const& parser, std::size_t from, bool matched) const {
+                if (matched) {
+                    tracer->exit(rule_info{ &parser, &type_tag<Parser>::id, impl::rule_name<Parser>() }, from, static_cast<std::size_t>(data() - base));
+                } else {
+                    tracer->fail(rule_info{ &parser, &type_tag<Parser>::id, impl::rule_name<Parser>() }, from);
+                }
+                return matched;
+            }
+
+            Tracer* tracer;
+            char const* base;
+        };
+
+        template <typename Input>
+        struct is_traced : std::false_type {};
+
+        // Input with lm::padding zero bytes after it.  The parsers only
+        // drop bytes from the front, so every suffix is padded too.
+        struct padded_view : std::string_view {
+            constexpr explicit padded_view(std::string_view sv) noexcept
+                : std::string_view(sv)
+            {}
+        };
+
+        // What is left of the limits of a parse
+        struct budget {
+            std::size_t steps;
+            std::size_t depth;
+            parse_result stop = parse_result::matched;
+        };
+
+        // Input that spends a step on every visit.  The budget is shared, not
+        // copied, so backtracking doesn't give the steps back.  Once a limit
+        // is hit the steps are gone and every visit fails at once, so the
+        // parse unwinds without doing any more work.
+        struct budget_view : std::string_view {
+            constexpr budget_view(std::string_view sv, budget* left) noexcept
+                : std::string_view(sv)
+                , left(left)
+            {}
+
+            constexpr bool enter() const noexcept {
+                if (left->steps == 0 || left->depth == 0) {
+                    if (left->stop == parse_result::matched) {
+                        left->stop = left->steps == 0 ? parse_result::out_of_steps : parse_result::too_deep;
+                    }
+                    left->steps = 0;
+                    return false;
+                }
+                --left->steps;
+                --left->depth;
+                return true;
+            }
+
+            constexpr bool leave(bool matched) const noexcept {
+                ++left->depth;
+                return matched;
+            }
+
+            budget* left;
+        };
+
+        // True for a callback that only takes std::string_view&.  Given a
+        // budget_view it gets the text without the budget, so its parse_ref
+        // would parse on without limits.  Generic callbacks (auto&) are not
+        // looked into and are false.
+        template <typename Func, typename = void>
+        struct sliced_callback : std::false_type {};
+
+        template <typename Call>
+        struct sliced_call : std::false_type {};
+
+        template <typename R, typename Arg>
+        struct sliced_call<R (*)(Arg)> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename Arg>
+        struct sliced_call<R (*)(Arg) noexcept> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename C, typename Arg>
+        struct sliced_call<R (C::*)(Arg)> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename C, typename Arg>
+        struct sliced_call<R (C::*)(Arg) const> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename C, typename Arg>
+        struct sliced_call<R (C::*)(Arg) noexcept> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename C, typename Arg>
+        struct sliced_call<R (C::*)(Arg) const noexcept> : std::is_same<Arg, std::string_view&> {};
+
+        template <typename R, typename Arg>
+        struct sliced_callback<R (*)(Arg), void> : sliced_call<R (*)(Arg)> {};
+
+        template <typename R, typename Arg>
+        struct sliced_callback<R (*)(Arg) noexcept, void> : sliced_call<R (*)(Arg) noexcept> {};
+
+        template <typename Func>
+        struct sliced_callback<Func, std::void_t<decltype(&Func::operator())>> : sliced_call<decltype(&Func::operator())> {};
+
+        template <typename Tracer>
+        struct is_traced<traced_view<Tracer>> : std::true_type {};
+
+        inline bool skip(std::string_view& sv, Skipper& skipper) noexcept {
+            return skipper.skip(sv);
+        }
+
+        // the lexer already dropped the whitespace between tokens
+        inline bool skip(token_stream&, Skipper&) noexcept {
+            return false;
+        }
+
+        // the part of before that was consumed to get to after
+        constexpr std::string_view matched(std::string_view const& before, std::string_view const& after) noexcept {
+            return before.substr(0, before.size() - after.size());
+        }
+
+        // for tokens, the matched source text runs from the first consumed
+        // token to the end of the last consumed token
+        constexpr std::string_view matched(token_stream const& before, token_stream const& after) noexcept {
+            if (before.first == after.first) {
+                return before.empty()
+                    ? before.source.substr(before.source.size())
+                    : before.source.substr(before.first->offset, 0);
+            }
+            token const& back = *(after.first - 1);
+            return before.source.substr(before.first->offset, back.offset + back.length - before.first->offset);
+        }
+
+        // Composite parsers skip on entry.  When a combinator has just skipped
+        // the input, it calls visit_skipped() so the child doesn't skip again.
+        struct skips_on_entry {};
+
+        // The rewrite pass behind lm::optimize.  It rebuilds combinators from
+        // their children, so they make it a friend.
+        struct rewrite;
+
+        template <bool Skipped, typename Parser, typename Input>
+        constexpr bool visit_child(Parser const& parser, Input& sv, Skipper& skipper) noexcept {
+            if constexpr (Skipped && std::is_base_of_v<skips_on_entry, Parser>) {
+                return parser.run(sv, skipper);
+            } else {
+                return parser.visit(sv, skipper);
+            }
+        }
+
+        // Every visit of a child goes through here, so the inputs that watch
+        // a parse (traced_view, budget_view) see all of them.  For the other
+        // inputs this is just the visit.
+        template <bool Skipped, typename Parser, typename Input>
+        constexpr bool visit_hooked(Parser const& parser, Input& sv, Skipper& skipper) noexcept {
+            if constexpr (is_traced<Input>::value) {
+                const std::size_t from = sv.enter(parser);
+                return sv.leave(parser, from, visit_child<Skipped>(parser, sv, skipper));
+            } else if constexpr (std::is_same_v<Input, budget_view>) {
+                return sv.enter() && sv.leave(visit_child<Skipped>(parser, sv, skipper));
+            } else {
+                return visit_child<Skipped>(parser, sv, skipper);
+            }
+        }
+
+        template <typename Parser, typename Input>
+        constexpr bool visit_skipped(Parser const& parser, Input& sv, Skipper& skipper) noexcept {
+            return visit_hooked<true>(parser, sv, skipper);
+        }
+
+        // parser.visit(), for children that skip for themselves
+        template <typename Parser, typename Input>
+        constexpr bool visit(Parser const& parser, Input& sv, Skipper& skipper) noexcept {
+            return visit_hooked<false>(parser, sv, skipper);
+        }
+
+        // A set of bytes, used for the FIRST set of a parser: the bytes that
+        // a non-empty match can start with.  Every parser over characters
+        // has first(set), which adds its FIRST set and returns true if it
+        // can also match empty.  Searches only try the grammar at those bytes.
+        struct byteset {
+            constexpr void insert(unsigned char ch) noexcept {
+                bits[ch >> 6] |= std::uint64_t(1) << (ch & 63);
+            }
+
+            constexpr void insert_all() noexcept {
+                bits[0] = bits[1] = bits[2] = bits[3] = ~std::uint64_t(0);
+            }
+
+            constexpr bool contains(unsigned char ch) const noexcept {
+                return (bits[ch >> 6] >> (ch & 63)) & 1;
+            }
+
+            constexpr std::size_t count() const noexcept {
+                std::size_t n = 0;
+                for (unsigned ch = 0; ch < 256; ++ch)
+                    n += contains(static_cast<unsigned char>(ch));
+                return n;
+            }
+
+            std::uint64_t bits[4] = {};
+        };
+
+        constexpr std::uint64_t byte_at(char const* p, std::size_t i) noexcept {
+            return static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        }
+
+        // The 8 bytes at p as a little-endian word.  Spelled out so that the
+        // compiler turns it into a single load (and it stays constexpr)
+        constexpr std::uint64_t load_u64(char const* p) noexcept {
+            return byte_at(p, 0) | byte_at(p, 1) | byte_at(p, 2) | byte_at(p, 3)
+                 | byte_at(p, 4) | byte_at(p, 5) | byte_at(p, 6) | byte_at(p, 7);
+        }
+
+        // The number of set bits in x
+        constexpr std::size_t popcount64(std::uint64_t x) noexcept {
+#ifndef _MSC_VER
+            return static_cast<std::size_t>(__builtin_popcountll(x));
+#else
+            x -= (x >> 1) & 0x5555555555555555u;
+            x = (x & 0x3333333333333333u) + ((x >> 2) & 0x3333333333333333u);
+            x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fu;
+            return static_cast<std::size_t>((x * 0x0101010101010101u) >> 56);
+#endif
+        }
+
+        // The index of the lowest set bit of x, which must not be 0
+        constexpr std::size_t ctz64(std::uint64_t x) noexcept {
+#ifndef _MSC_VER
+            return static_cast<std::size_t>(__builtin_ctzll(x));
+#else
+            return popcount64((x & (0 - x)) - 1);
+#endif
+        }
+
+        // The high bit of each byte of x that is outside [lo, hi], for
+        // hi < 0x80.  Bytes >= 0x80 are outside; they can carry into the
+        // next byte, but the word already fails then.
+        constexpr std::uint64_t outside_range(std::uint64_t x, unsigned char lo, unsigned char hi) noexcept {
+            constexpr std::uint64_t ones = 0x0101010101010101u;
+            constexpr std::uint64_t high = 0x8080808080808080u;
+            const std::uint64_t above = x + ones * (0x7f - hi);  // high bit set if x > hi
+            const std::uint64_t below = ~((x | high) - ones * lo); // high bit set if x < lo
+            return (x | above | below) & high;
+        }
+
+        // True if the first n bytes of sv are all in [lo, hi].  Checks 8
+        // bytes per word; the last word overlaps the one before it, or is
+        // masked to n bytes when the input has room for a whole word.
+        constexpr bool all_in_range(std::string_view sv, std::size_t n, unsigned char lo, unsigned char hi) noexcept {
+            if (n == 0)
+                return true; // and the mask below would shift by 64
+            if (n > sv.size())
+                return false;
+            char const* p = sv.data();
+            if (hi < 0x80 && lo <= hi && (n >= 8 || sv.size() >= 8)) {
+                if (n < 8)
+                    return (outside_range(load_u64(p), lo, hi) & (~std::uint64_t(0) >> (64 - 8 * n))) == 0;
+                std::uint64_t bad = 0;
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                    bad |= outside_range(load_u64(p + i), lo, hi);
+                if (i != n)
+                    bad |= outside_range(load_u64(p + n - 8), lo, hi);
+                return bad == 0;
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                const unsigned char ch = static_cast<unsigned char>(p[i]);
+                if (ch < lo || ch > hi)
+                    return false;
+            }
+            return true;
+        }
+
         template <typename Base>
         struct parser_base {
             constexpr auto operator*() const noexcept;
@@ -96,6 +724,19 @@ namespace lm {
                     return false;
                 }
 
+                constexpr bool test(char c) const noexcept {
+                    return c != ch;
+                }
+
+                // out may hold the bytes of other parsers, so only add to it
+                inline bool first(impl::byteset& out) const noexcept {
+                    impl::byteset excluded;
+                    excluded.insert(static_cast<unsigned char>(ch));
+                    for (int i = 0; i < 4; ++i)
+                        out.bits[i] |= ~excluded.bits[i];
+                    return false;
+                }
+
             private:
                 char ch;
             };
@@ -111,6 +752,29 @@ namespace lm {
             return false;
         }
 
+        constexpr bool test(char c) const noexcept {
+            return c == ch;
+        }
+
+        constexpr bool first(impl::byteset& set) const noexcept {
+            set.insert(static_cast<unsigned char>(ch));
+            return false;
+        }
+
+        // true if the first n characters of sv all match, a word at a time
+        constexpr bool span(std::string_view sv, std::size_t n) const noexcept {
+            return impl::all_in_range(sv, n, static_cast<unsigned char>(ch), static_cast<unsigned char>(ch));
+        }
+
+        // the high bit of each byte of the word that doesn't match, if ascii()
+        constexpr std::uint64_t outside(std::uint64_t x) const noexcept {
+            return impl::outside_range(x, static_cast<unsigned char>(ch), static_cast<unsigned char>(ch));
+        }
+
+        constexpr bool ascii() const noexcept {
+            return static_cast<unsigned char>(ch) < 0x80;
+        }
+
     private:
         char ch;
     };
@@ -155,6 +819,24 @@ namespace lm {
                     return false;
                 }
 
+                constexpr bool test(char c) const noexcept {
+                    for (char const* s = set; *s; ++s) {
+                        if (*s == c) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                inline bool first(impl::byteset& out) const noexcept {
+                    impl::byteset excluded;
+                    for (char const* s = set; *s; ++s)
+                        excluded.insert(static_cast<unsigned char>(*s));
+                    for (int i = 0; i < 4; ++i)
+                        out.bits[i] |= ~excluded.bits[i];
+                    return false;
+                }
+
             private:
                 char const* set;
             };
@@ -174,6 +856,21 @@ namespace lm {
             return false;
         }
 
+        constexpr bool test(char c) const noexcept {
+            for (char const* s = set; *s; ++s) {
+                if (*s == c) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        constexpr bool first(impl::byteset& out) const noexcept {
+            for (char const* s = set; *s; ++s)
+                out.insert(static_cast<unsigned char>(*s));
+            return false;
+        }
+
     private:
         char const* set;
     };
@@ -201,31 +898,132 @@ namespace lm {
             return false;
         }
 
+        constexpr bool test(char c) const noexcept {
+            return pred(c);
+        }
+
+        // asks the predicate about every byte
+        constexpr bool first(impl::byteset& set) const noexcept {
+            for (unsigned ch = 0; ch < 256; ++ch)
+                if (pred(static_cast<char>(ch)))
+                    set.insert(static_cast<unsigned char>(ch));
+            return false;
+        }
+
     private:
         bool(*pred)(char);
     };
 
-    // These are not constexpr because the underlying functions in cctype aren't
+    /// @class range_
+    /// @brief Single character parser for a range of characters
+    /// @details An object of this type parses one character from \p lo to
+    ///     \p hi, inclusive.  For example, `lm::range_('a', 'f')` parses
+    ///     "a", "b", ... "f".  Unlike `lm::char_if_`, it is constexpr and
+    ///     `lm::repeat_` checks a fixed number of them a word at a time.
+    struct range_ final : public impl::parser_base<range_> {
+        /// @brief Construct a range_ parser
+        /// @param[in] lo The first character to accept.
+        /// @param[in] hi The last character to accept.
+        constexpr range_(const char lo, const char hi) noexcept
+            : lo(static_cast<unsigned char>(lo))
+            , hi(static_cast<unsigned char>(hi))
+        {}
 
-    /// @var alnum_
-    /// @brief Single character parser based on std::isalnum
-    [[maybe_unused ]] static inline auto alnum_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isalnum(ch); });
+        /// @brief Opposite parser
+        /// @details Construct a parser that accepts all characters
+        ///     outside the range.
+        constexpr inline auto operator!() const& noexcept {
+            struct not_ final : impl::parser_base<not_> {
+                constexpr not_(unsigned char lo, unsigned char hi) noexcept
+                    : lo(lo)
+                    , hi(hi)
+                {}
 
-    /// @var alpha_
-    /// @brief Single character parser based on std::isalpha
-    [[maybe_unused ]] static inline auto alpha_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isalpha(ch); });
+                constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                    if (!sv.empty() && static_cast<unsigned char>(static_cast<unsigned char>(sv.front()) - lo) > hi - lo) {
+                        sv.remove_prefix(1);
+                        return true;
+                    }
+                    return false;
+                }
 
-    /// @var lower_
-    /// @brief Single character parser based on std::islower
-    [[maybe_unused ]] static inline auto lower_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::islower(ch); });
+                constexpr bool test(char c) const noexcept {
+                    return static_cast<unsigned char>(static_cast<unsigned char>(c) - lo) > hi - lo;
+                }
 
-    /// @var upper_
-    /// @brief Single character parser based on std::isupper
-    [[maybe_unused ]] static inline auto upper_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isupper(ch); });
+                inline bool first(impl::byteset& set) const noexcept {
+                    for (unsigned ch = 0; ch < 256; ++ch)
+                        if (ch < lo || ch > hi)
+                            set.insert(static_cast<unsigned char>(ch));
+                    return false;
+                }
 
-    /// @var digit_
-    /// @brief Single character parser based on std::isdigit
-    [[maybe_unused ]] static inline auto digit_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isdigit(ch); });
+            private:
+                unsigned char lo;
+                unsigned char hi;
+            };
+
+            return not_(lo, hi);
+        }
+
+        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            if (!sv.empty() && static_cast<unsigned char>(static_cast<unsigned char>(sv.front()) - lo) <= hi - lo) {
+                sv.remove_prefix(1);
+                return true;
+            }
+            return false;
+        }
+
+        constexpr bool test(char c) const noexcept {
+            return static_cast<unsigned char>(static_cast<unsigned char>(c) - lo) <= hi - lo;
+        }
+
+        constexpr bool first(impl::byteset& set) const noexcept {
+            for (unsigned ch = lo; ch <= hi; ++ch)
+                set.insert(static_cast<unsigned char>(ch));
+            return false;
+        }
+
+        // true if the first n characters of sv are all in the range, a word at a time
+        constexpr bool span(std::string_view sv, std::size_t n) const noexcept {
+            return impl::all_in_range(sv, n, lo, hi);
+        }
+
+        // the high bit of each byte of the word outside the range, if ascii()
+        constexpr std::uint64_t outside(std::uint64_t x) const noexcept {
+            return impl::outside_range(x, lo, hi);
+        }
+
+        constexpr bool ascii() const noexcept {
+            return lo <= hi && hi < 0x80;
+        }
+
+    private:
+        unsigned char lo;
+        unsigned char hi;
+    };
+
+    // These are not constexpr because the underlying functions in cctype aren't
+
+    /// @var alnum_
+    /// @brief Single character parser based on std::isalnum
+    [[maybe_unused ]] static inline auto alnum_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isalnum(ch); });
+
+    /// @var alpha_
+    /// @brief Single character parser based on std::isalpha
+    [[maybe_unused ]] static inline auto alpha_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isalpha(ch); });
+
+    /// @var lower_
+    /// @brief Single character parser based on std::islower
+    [[maybe_unused ]] static inline auto lower_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::islower(ch); });
+
+    /// @var upper_
+    /// @brief Single character parser based on std::isupper
+    [[maybe_unused ]] static inline auto upper_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::isupper(ch); });
+
+    /// @var digit_
+    /// @brief Single character parser for '0' to '9', like std::isdigit
+    [[maybe_unused ]] constexpr static inline auto digit_ = range_('0', '9');
 
     /// @var xdigit_
     /// @brief Single character parser based on std::xdigit
@@ -255,11 +1053,138 @@ namespace lm {
     /// @brief Single character parser based on std::punct
     [[maybe_unused ]] static inline auto punct_ = char_if_([](char const ch) noexcept -> bool { return 0 != std::ispunct(ch); });
 
+    namespace impl {
+        constexpr bool is_ascii_alpha(char ch) noexcept {
+            return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z');
+        }
+
+        constexpr char ascii_lower(char ch) noexcept {
+            return ('A' <= ch && ch <= 'Z') ? static_cast<char>(ch | 0x20) : ch;
+        }
+
+        constexpr std::uint32_t load_u32(char const* p) noexcept {
+            return static_cast<std::uint32_t>(byte_at(p, 0) | byte_at(p, 1) | byte_at(p, 2) | byte_at(p, 3));
+        }
+
+        constexpr std::uint32_t load_u16(char const* p) noexcept {
+            return static_cast<std::uint32_t>(byte_at(p, 0) | byte_at(p, 1));
+        }
+
+        // true if sv starts with str.  Up to 16 bytes are compared with two
+        // loads of the same width from each, the first and the last bytes
+        // of str (they overlap unless the size is a power of two, like in
+        // memcmp), so nothing past the end of either is read.  Out of line,
+        // so that a wide alt_ of literals doesn't inline one for each
+        LIMN_NOINLINE constexpr bool starts_with(std::string_view sv, std::string_view str) noexcept {
+            std::size_t const n = str.size();
+            if (sv.size() < n)
+                return false;
+            char const* p = sv.data();
+            char const* q = str.data();
+            if (n >= 8) {
+                if (n > 16)
+                    return sv.substr(0, n) == str;
+                return ((load_u64(p) ^ load_u64(q)) | (load_u64(p + n - 8) ^ load_u64(q + n - 8))) == 0;
+            }
+            if (n >= 4)
+                return ((load_u32(p) ^ load_u32(q)) | (load_u32(p + n - 4) ^ load_u32(q + n - 4))) == 0;
+            if (n >= 2)
+                return ((load_u16(p) ^ load_u16(q)) | (load_u16(p + n - 2) ^ load_u16(q + n - 2))) == 0;
+            return n == 0 || p[0] == q[0];
+        }
+
+        // Packs up to 8 bytes of str from from into a word, or with mask, the
+        // bits of those bytes that take part in the compare.  The letters are
+        // packed lowercase and their 0x20 (case) bit is left out of the mask,
+        // so ((input ^ word) & mask) == 0 is the same as comparing
+        // (input | 0x20) to the word at those bytes.
+        constexpr std::uint64_t pack_folded(std::string_view str, std::size_t from, bool mask) noexcept {
+            std::uint64_t w = 0;
+            for (std::size_t i = 0; i < 8 && from + i < str.size(); ++i) {
+                char const ch = str[from + i];
+                unsigned const byte = mask
+                    ? (is_ascii_alpha(ch) ? 0xdf : 0xff)
+                    : static_cast<unsigned char>(ascii_lower(ch));
+                w |= static_cast<std::uint64_t>(byte) << (8 * i);
+            }
+            return w;
+        }
+
+        // A case-insensitive literal, packed into words at construction.
+        // With the whole literal and at least 8 bytes of input left, a
+        // literal of up to 16 bytes matches with two word loads and masked
+        // compares: the first 8 bytes, and the last 8 bytes of a literal
+        // longer than 8 (the loads overlap, like in memcmp).
+        struct folded_lit_ {
+            constexpr explicit folded_lit_(std::string_view str) noexcept
+                : str(str)
+                , lo(pack_folded(str, 0, false))
+                , hi(str.size() > 8 ? pack_folded(str, str.size() - 8, false) : 0)
+                , lo_mask(pack_folded(str, 0, true))
+                , hi_mask(str.size() > 8 ? pack_folded(str, str.size() - 8, true) : 0)
+            {}
+
+            constexpr std::size_t size() const noexcept {
+                return str.size();
+            }
+
+            constexpr std::string_view text() const noexcept {
+                return str;
+            }
+
+            // true if sv starts with the literal
+            constexpr bool match(std::string_view sv) const noexcept {
+                std::size_t const n = str.size();
+                // both loads must stay inside sv
+                if (sv.size() >= 8 && sv.size() >= n && n <= 16) {
+                    return compare(sv.data());
+                }
+                return match_slow(sv);
+            }
+
+            // true if sv starts with the literal, when sv has lm::padding
+            // bytes after it, so the words can be loaded near its end too
+            constexpr bool match_padded(std::string_view sv) const noexcept {
+                if (str.size() <= 16) {
+                    return str.size() <= sv.size() && compare(sv.data());
+                }
+                return match_slow(sv);
+            }
+
+        private:
+            constexpr bool compare(char const* p) const noexcept {
+                std::size_t const n = str.size();
+                std::uint64_t const first = load_u64(p);
+                std::uint64_t const last = load_u64(p + (n > 8 ? n - 8 : 0));
+                return (((first ^ lo) & lo_mask) | ((last ^ hi) & hi_mask)) == 0;
+            }
+
+            // near the end of the input, or literals longer than 16 bytes.
+            // Kept out of line so match() stays small enough to inline
+            LIMN_NOINLINE constexpr bool match_slow(std::string_view sv) const noexcept {
+                std::size_t const n = str.size();
+                if (sv.size() < n)
+                    return false;
+                for (std::size_t i = 0; i < n; ++i)
+                    if (ascii_lower(sv[i]) != ascii_lower(str[i]))
+                        return false;
+                return true;
+            }
+
+            std::string_view str;
+            std::uint64_t lo;
+            std::uint64_t hi;
+            std::uint64_t lo_mask;
+            std::uint64_t hi_mask;
+        };
+    }
+
     /// @class lit_
     /// @brief String literal parser
     /// @details An object of this type matches a character sequence (AKA
     ///     a string literal).  For example, `lm::lit_("tautological")`
-    ///     would parse the string "tautological".
+    ///     would parse the string "tautological".  Literals of up to
+    ///     16 characters match with one or two word compares.
     struct lit_ final : public impl::parser_base<lit_> {
         /// @brief Construct a lit_ parser.
         /// @param[in] str The string literal to parse.
@@ -268,17 +1193,123 @@ namespace lm {
         {}
 
         constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-            if (sv.substr(0, str.size()) == str) {
+            // most tries of an alt_ of literals end at the first byte
+            if (!str.empty() && (sv.empty() || sv.front() != str.front())) {
+                return false;
+            }
+            if (impl::starts_with(sv, str)) {
                 sv.remove_prefix(str.size());
                 return true;
             }
             return false;
         }
 
+        inline bool first(impl::byteset& set) const noexcept {
+            if (str.empty())
+                return true;
+            set.insert(static_cast<unsigned char>(str.front()));
+            return false;
+        }
+
     private:
+        friend struct impl::rewrite;
+
+        // only the text: a wide alt_ moves its literals into each node of
+        // the chain it is built from, so their size is compile time
         std::string_view str;
     };
 
+    /// @class ilit_
+    /// @brief Case-insensitive string literal parser
+    /// @details Like `lm::lit_`, but ASCII letters match in either case.
+    ///     For example, `lm::ilit_("Content-Length")` parses
+    ///     "content-length" and "CONTENT-LENGTH".
+    struct ilit_ final : public impl::parser_base<ilit_> {
+        /// @brief Construct an ilit_ parser.
+        /// @param[in] str The string literal to parse.
+        constexpr ilit_(std::string_view str) noexcept
+            : str(str)
+        {}
+
+        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            if (str.match(sv)) {
+                sv.remove_prefix(str.size());
+                return true;
+            }
+            return false;
+        }
+
+        constexpr inline bool visit(impl::padded_view& sv, Skipper& skipper) const& noexcept {
+            if (str.match_padded(sv)) {
+                sv.remove_prefix(str.size());
+                return true;
+            }
+            return false;
+        }
+
+        inline bool first(impl::byteset& set) const noexcept {
+            if (str.size() == 0)
+                return true;
+            char const ch = str.text().front();
+            set.insert(static_cast<unsigned char>(impl::ascii_lower(ch)));
+            if (impl::is_ascii_alpha(ch))
+                set.insert(static_cast<unsigned char>(impl::ascii_lower(ch) & 0xdf));
+            return false;
+        }
+
+    private:
+        impl::folded_lit_ str;
+    };
+
+    /// @class tok_
+    /// @brief Single token parser based on a token kind
+    /// @details An object of this type parses one token from a
+    ///     `lm::token_stream`.  For example, `lm::tok_(IDENT)` accepts
+    ///     the next token if the lexer classified it as IDENT.
+    struct tok_ final : public impl::parser_base<tok_> {
+        /// @brief Construct a tok_ parser
+        /// @param[in] kind The token kind to accept.
+        constexpr explicit tok_(const std::uint16_t kind) noexcept
+            : kind(kind)
+        {}
+
+        constexpr inline bool visit(token_stream& ts, Skipper& skipper) const& noexcept {
+            if (!ts.empty() && ts.front().kind == kind) {
+                ts.remove_prefix(1);
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::uint16_t kind;
+    };
+
+    /// @class kw_
+    /// @brief Keyword parser over a token stream
+    /// @details An object of this type parses one token whose text
+    ///     is exactly the keyword, whatever its kind.  For example,
+    ///     `lm::kw_("template")` accepts the identifier token "template"
+    ///     but not "templates".
+    struct kw_ final : public impl::parser_base<kw_> {
+        /// @brief Construct a kw_ parser
+        /// @param[in] word The keyword to accept.
+        constexpr explicit kw_(std::string_view word) noexcept
+            : word(word)
+        {}
+
+        constexpr inline bool visit(token_stream& ts, Skipper& skipper) const& noexcept {
+            if (!ts.empty() && ts.text(ts.front()) == word) {
+                ts.remove_prefix(1);
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::string_view word;
+    };
+
     /// @class action_
     /// @brief Customizable parser
     /// @details An object of this type uses a callback to
@@ -312,10 +1343,19 @@ namespace lm {
             : func(std::forward<Func>(func))
         {}
 
-        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+        template <typename Input>
+        constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+            static_assert(!std::is_same_v<Input, impl::budget_view> || !impl::sliced_callback<std::decay_t<Func>>::value,
+                "with lm::limits, an action_ callback takes auto& and passes it to lm::parse_ref, or the limits are lost");
             return func(sv); // func returns false to fail the parse
         }
 
+        // the callback is opaque, so it could start anywhere
+        inline bool first(impl::byteset& set) const noexcept {
+            set.insert_all();
+            return true;
+        }
+
     private:
         Func func;
     };
@@ -326,18 +1366,34 @@ namespace lm {
     /// For example, `opt_( lm::lit_("hello") )` can parse the string "hello" or the empty
     /// string, so it is a simplied form of `lm::lit_("hello") | empty_`.
     template <typename Base>
-    struct opt_ final : public impl::parser_base<opt_<Base>> {
+    struct opt_ final : public impl::parser_base<opt_<Base>>, impl::skips_on_entry {
         constexpr explicit opt_(Base base) noexcept
             : base(std::forward<Base>(base))
         {}
 
-        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-            skipper.skip(sv);
-            base.visit(sv, skipper);
+        template <typename Input>
+        constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+            impl::skip(sv, skipper);
+            return run(sv, skipper);
+        }
+
+        template <typename Input>
+        constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+            const Input save = sv;
+            if (!impl::visit_skipped(base, sv, skipper)) {
+                sv = save; // nothing of a failed attempt is kept
+            }
+            return true;
+        }
+
+        inline bool first(impl::byteset& set) const noexcept {
+            base.first(set);
             return true;
         }
 
     private:
+        friend struct impl::rewrite;
+
         Base base;
     };
 
@@ -350,156 +1406,621 @@ namespace lm {
             : base(std::forward<Base>(base))
         {}
 
-        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+        template <typename Input>
+        constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
             // skipper.skip(sv);
             // nosk.skip(sv);
-            return base.visit(sv, nosk); // lexeme is atomic, so don't use passed skipper, use nosk instead;
+            return impl::visit(base, sv, nosk); // lexeme is atomic, so don't use passed skipper, use nosk instead;
+        }
+
+        inline bool first(impl::byteset& set) const noexcept {
+            return base.first(set);
+        }
+
+    private:
+        friend struct impl::rewrite;
+
+        Base base;
+    };
+
+    /// @class capture_
+    /// @brief Records each match of its parser in a `lm::capture_buffer`
+    /// @details Unlike `operator[](std::string_view&)`, which keeps only the
+    ///     last match, every match is recorded, so
+    ///     `*lm::capture_(WORD, lm::lexeme_(+lm::alpha_))` gives all the
+    ///     words.  Captures made in a branch that is later backtracked are
+    ///     dropped.  Outside of `lm::parse(input, parser, captures)` this
+    ///     is just its parser.
+    template <typename Base>
+    struct capture_ final : public impl::parser_base<capture_<Base>>, impl::skips_on_entry {
+        /// @brief Construct a capture_ parser
+        /// @param[in] tag Stored with each capture, to tell them apart
+        /// @param[in] base The parser whose matches are recorded
+        constexpr capture_(std::uint32_t tag, Base base) noexcept
+            : tag(tag)
+            , base(std::move(base))
+        {}
+
+        template <typename Input>
+        constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+            impl::skip(sv, skipper);
+            return run(sv, skipper);
+        }
+
+        template <typename Input>
+        constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+            if constexpr (std::is_same_v<Input, impl::capture_view>) {
+                // take the slot first so that outer captures come before inner ones
+                const std::size_t index = sv.count++;
+                const std::size_t begin = sv.buffer->source.size() - sv.size();
+                if (!impl::visit_skipped(base, sv, skipper)) {
+                    return false;
+                }
+                const std::size_t end = sv.buffer->source.size() - sv.size();
+                impl::capture_access::store(*sv.buffer, index, capture{tag, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end)});
+                return true;
+            } else {
+                return impl::visit_skipped(base, sv, skipper);
+            }
+        }
+
+        inline bool first(impl::byteset& set) const noexcept {
+            return base.first(set);
         }
 
     private:
+        friend struct impl::rewrite;
+
+        std::uint32_t tag;
         Base base;
     };
 
     namespace impl {
-        template <typename Left, typename Right>
-        struct seq_ final : public impl::parser_base<seq_<Left, Right>> {
-            constexpr explicit seq_(Left&& left, Right&& right) noexcept
-                : left(std::forward<Left>(left))
-                , right(std::forward<Right>(right))
+        // One child of a variadic combinator.  Children live in distinct
+        // bases instead of a std::tuple because that is cheaper to instantiate.
+        template <std::size_t I, typename Parser>
+        struct child_ {
+            Parser parser;
+        };
+
+        template <std::size_t I, typename Parser>
+        constexpr Parser const& child(child_<I, Parser> const& c) noexcept {
+            return c.parser;
+        }
+
+        template <std::size_t I, typename Parser>
+        constexpr Parser& child(child_<I, Parser>& c) noexcept {
+            return c.parser;
+        }
+
+        template <typename Indices, typename... Parsers>
+        struct children_;
+
+        template <std::size_t... Is, typename... Parsers>
+        struct children_<std::index_sequence<Is...>, Parsers...> : child_<Is, Parsers>... {
+            constexpr explicit children_(Parsers&&... parsers) noexcept
+                : child_<Is, Parsers>{std::forward<Parsers>(parsers)}...
             {}
+        };
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                bool left_result = left.visit(sv, skipper);
-                if (left_result)
-                {
-                    skipper.skip(sv);
-                    return right.visit(sv, skipper);
-                }
-                else
-                    return false;
+        template <typename... Parsers>
+        struct seq_ final : public impl::parser_base<seq_<Parsers...>>, impl::skips_on_entry
+                          , children_<std::index_sequence_for<Parsers...>, Parsers...> {
+            constexpr explicit seq_(Parsers&&... parsers) noexcept
+                : children_<std::index_sequence_for<Parsers...>, Parsers...>(std::forward<Parsers>(parsers)...)
+            {}
+
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                return run(sv, skipper, std::index_sequence_for<Parsers...>());
+            }
+
+            // a child can start the match only if the ones before it can be empty
+            inline bool first(impl::byteset& set) const noexcept {
+                return first(set, std::index_sequence_for<Parsers...>());
             }
 
         private:
-            Left left;
-            Right right;
+            template <std::size_t... Is>
+            inline bool first(impl::byteset& set, std::index_sequence<Is...>) const noexcept {
+                return (impl::child<Is>(*this).first(set) && ...);
+            }
+
+            // skip between the children, the first one starts where we already are
+            template <typename Input, std::size_t... Is>
+            constexpr inline bool run(Input& sv, Skipper& skipper, std::index_sequence<Is...>) const& noexcept {
+                return (((Is == 0 || (impl::skip(sv, skipper), true))
+                    && impl::visit_skipped(impl::child<Is>(*this), sv, skipper)) && ...);
+            }
         };
 
-        template <typename Left, typename Right>
-        struct alt_ final : public impl::parser_base<alt_<Left, Right>> {
-            constexpr explicit alt_(Left&& left, Right&& right) noexcept
-                : left(std::forward<Left>(left))
-                , right(std::forward<Right>(right))
+        template <typename... Parsers>
+        struct alt_ final : public impl::parser_base<alt_<Parsers...>>, impl::skips_on_entry
+                          , children_<std::index_sequence_for<Parsers...>, Parsers...> {
+            constexpr explicit alt_(Parsers&&... parsers) noexcept
+                : children_<std::index_sequence_for<Parsers...>, Parsers...>(std::forward<Parsers>(parsers)...)
             {}
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                const std::string_view save = sv; // rewind the string_view if left failed, save should not be reference
-                return left.visit(sv, skipper) || right.visit(sv = save, skipper);  // reset the sv when calling the right parser
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                return run(sv, skipper, std::index_sequence_for<Parsers...>());
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                return first(set, std::index_sequence_for<Parsers...>());
             }
 
         private:
-            Left left;
-            Right right;
+            // every branch is visited, no short circuit
+            template <std::size_t... Is>
+            inline bool first(impl::byteset& set, std::index_sequence<Is...>) const noexcept {
+                return (static_cast<int>(impl::child<Is>(*this).first(set)) | ...) != 0;
+            }
+
+            // rewind the input before each branch, save should not be a reference
+            template <typename Input, std::size_t... Is>
+            constexpr inline bool run(Input& sv, Skipper& skipper, std::index_sequence<Is...>) const& noexcept {
+                const Input save = sv;
+                return (impl::visit_skipped(impl::child<Is>(*this), sv = save, skipper) || ...);
+            }
         };
 
+        // Rebuild a combinator with one more child.  The children of an
+        // unnamed (rvalue) chain are moved into the new node, so
+        // `a >> b >> c` is one seq_<A, B, C> instead of seq_<seq_<A, B>, C>.
+        template <template <typename...> class Node, typename... Parsers, std::size_t... Is, typename Last>
+        constexpr auto append(Node<Parsers...>&& node, std::index_sequence<Is...>, Last&& last) noexcept {
+            return Node<Parsers..., Last>(
+                static_cast<Parsers&&>(impl::child<Is>(node))...,
+                std::forward<Last>(last)
+            );
+        }
+
+        // The character classes can test a byte without an input around it
+        template <typename Base, typename = void>
+        struct has_test : std::false_type {};
+
+        template <typename Base>
+        struct has_test<Base, std::void_t<decltype(std::declval<Base const&>().test('a'))>> : std::true_type {};
+
+        template <typename Base, typename = void>
+        struct has_outside : std::false_type {};
+
+        template <typename Base>
+        struct has_outside<Base, std::void_t<decltype(std::declval<Base const&>().outside(std::uint64_t()))>> : std::true_type {};
+
+        // How many bytes at the front of sv the character class base
+        // matches.  The padding is zeros, so unless the class takes '\0' the
+        // scan stops there by itself: no bounds check per byte, and the
+        // classes that test a word at a time need no scalar tail.
+        template <typename Base>
+        constexpr std::size_t padded_span(Base const& base, padded_view const& sv) noexcept {
+            char const* p = sv.data();
+            std::size_t i = 0;
+            if (base.test('\0')) {
+                while (i < sv.size() && base.test(p[i])) {
+                    ++i;
+                }
+                return i;
+            }
+            if constexpr (has_outside<Base>::value) {
+                if (base.ascii()) {
+                    while (base.outside(load_u64(p + i)) == 0) {
+                        i += 8;
+                    }
+                }
+            }
+            while (base.test(p[i])) {
+                ++i;
+            }
+            return i;
+        }
+
         template <typename Base>
-        struct kleene_ final : public impl::parser_base<kleene_<Base>> {
+        struct kleene_ final : public impl::parser_base<kleene_<Base>>, impl::skips_on_entry {
             constexpr explicit kleene_(Base base) noexcept
                 : base(std::move(base))
             {}
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                std::string_view save = sv;
-                // save != sv means we does step forward (base.visit(sv) consume some chars)
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                if constexpr (std::is_same_v<Input, impl::padded_view> && impl::has_test<Base>::value) {
+                    sv.remove_prefix(impl::padded_span(base, sv));
+                    return true;
+                }
+                Input save = sv;
+                // a size change means we does step forward (base.visit(sv) consume some chars)
                 // the assignment save = sv means the sv get updated, so try next loop
-                // to see it goes forward again
-                while (base.visit(sv, skipper) && !sv.empty() && save != sv)
+                // to see it goes forward again.  Only the first pass starts at a
+                // position that is already skipped.  A failed pass is rewound.
+                bool more = impl::visit_skipped(base, sv, skipper);
+                while (more && !sv.empty() && save.size() != sv.size()) {
                     save = sv;
+                    more = impl::visit(base, sv, skipper);
+                }
+                if (!more) {
+                    sv = save;
+                }
+                return true;
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                base.first(set);
                 return true;
             }
 
         private:
+            friend struct rewrite;
+
             Base base;
         };
 
         template <typename Base>
-        struct plus_ final : public impl::parser_base<plus_<Base>> {
+        struct plus_ final : public impl::parser_base<plus_<Base>>, impl::skips_on_entry {
             constexpr explicit plus_(Base base) noexcept
                 : base(std::move(base))
             {}
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                if (!base.visit(sv, skipper)) {
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                if constexpr (std::is_same_v<Input, impl::padded_view> && impl::has_test<Base>::value) {
+                    const std::size_t n = impl::padded_span(base, sv);
+                    sv.remove_prefix(n);
+                    return n != 0;
+                }
+                if (!impl::visit_skipped(base, sv, skipper)) {
                     return false;
                 }
-                std::string_view save = sv;
-                // save != sv means we does step forward (base.visit(sv) consume some chars)
+                Input save = sv;
+                // a size change means we does step forward (base.visit(sv) consume some chars)
                 // the assignment save = sv means the sv get updated, so try next loop
-                // to see it goes forward again
-                while (base.visit(sv, skipper) && !sv.empty() && save != sv)
+                // to see it goes forward again.  A failed pass is rewound.
+                while (impl::visit(base, sv, skipper)) {
+                    if (sv.empty() || save.size() == sv.size()) {
+                        return true;
+                    }
                     save = sv;
+                }
+                sv = save;
                 return true;
             }
 
+            inline bool first(impl::byteset& set) const noexcept {
+                return base.first(set);
+            }
+
         private:
+            friend struct rewrite;
+
             Base base;
         };
 
+        template <typename Base, typename = void>
+        struct has_span : std::false_type {};
+
         template <typename Base>
-        struct match_ final : public impl::parser_base<match_<Base>> {
-            constexpr explicit match_(Base base, std::string_view& sv) noexcept
-                : base(std::move(base))
-                , out(sv)
-            {}
+        struct has_span<Base, std::void_t<decltype(std::declval<Base const&>().span(std::string_view(), 0))>> : std::true_type {};
+
+        // Exactly n of a single character parser in one go.  Character
+        // parsers don't skip, so this is the same as n visits.  Returns
+        // false if base can't do it.
+        template <typename Base, typename Input>
+        constexpr bool repeat_span(Base const& base, Input& sv, std::size_t n, bool& matched) noexcept {
+            if constexpr (has_span<Base>::value && std::is_convertible_v<Input const&, std::string_view>) {
+                matched = base.span(sv, n);
+                if (matched) {
+                    sv.remove_prefix(n);
+                }
+                return true;
+            } else {
+                return false;
+            }
+        }
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                std::string_view save = sv;
-                if (base.visit(sv, skipper)) {
-                    out = save.substr(0, save.size() - sv.size());
-                    return true;
+        // Between min and max of base, greedily, like kleene_.  A failed
+        // pass is rewound.
+        template <typename Base, typename Input>
+        constexpr bool repeat_run(Base const& base, Input& sv, std::size_t min, std::size_t max, Skipper& skipper) noexcept {
+            if (min == max) {
+                bool matched = false;
+                if (repeat_span(base, sv, min, matched)) {
+                    return matched;
+                }
+            }
+            const Input start = sv;
+            std::size_t count = 0;
+            while (count < max) {
+                Input save = sv;
+                const bool more = count == 0 ? impl::visit_skipped(base, sv, skipper) : impl::visit(base, sv, skipper);
+                if (!more) {
+                    sv = save;
+                    break;
+                }
+                ++count;
+                if (save.size() == sv.size()) {
+                    // an empty match would repeat forever, so it counts for all the rest
+                    count = max;
                 }
+            }
+            if (count < min) {
+                sv = start;
                 return false;
             }
+            return true;
+        }
 
-        private:
-            Base base;
-            std::string_view& out;
-        };
+        template <std::size_t Min, std::size_t Max, typename Base>
+        struct repeat_ final : public impl::parser_base<repeat_<Min, Max, Base>>, impl::skips_on_entry {
+            static_assert(Min <= Max, "repeat_<Min, Max> needs Min <= Max");
 
-        template <typename Base>
-        struct match_call_ final : public impl::parser_base<match_call_<Base>> {
-            constexpr explicit match_call_(Base base, std::function<void(const std::string_view&)> callback) noexcept
+            constexpr explicit repeat_(Base base) noexcept
                 : base(std::move(base))
-                , callback(std::move(callback))
             {}
 
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
-                skipper.skip(sv);
-                std::string_view save = sv;
-                if (base.visit(sv, skipper)) {
-                    callback(save.substr(0, save.size() - sv.size()));
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                return repeat_run(base, sv, Min, Max, skipper);
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                return base.first(set) || Min == 0;
+            }
+
+        private:
+            friend struct rewrite;
+
+            Base base;
+        };
+
+        template <typename Base>
+        struct repeat_n_ final : public impl::parser_base<repeat_n_<Base>>, impl::skips_on_entry {
+            constexpr repeat_n_(std::size_t min, std::size_t max, Base base) noexcept
+                : min(min)
+                , max(max < min ? min : max)
+                , base(std::move(base))
+            {}
+
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                return repeat_run(base, sv, min, max, skipper);
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                return base.first(set) || min == 0;
+            }
+
+        private:
+            friend struct rewrite;
+
+            std::size_t min;
+            std::size_t max;
+            Base base;
+        };
+
+        template <typename Elem, typename Sep>
+        struct list_ final : public impl::parser_base<list_<Elem, Sep>>, impl::skips_on_entry {
+            constexpr list_(Elem elem, Sep sep, std::size_t* count = nullptr) noexcept
+                : elem(std::move(elem))
+                , sep(std::move(sep))
+                , count(count)
+            {}
+
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            // elem, then (sep, elem) for as long as both match.  A separator
+            // without an element after it is left in the input.
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                if (!impl::visit_skipped(elem, sv, skipper)) {
+                    return false;
+                }
+                std::size_t n = 1;
+                for (;;) {
+                    const Input save = sv;
+                    impl::skip(sv, skipper);
+                    if (!impl::visit_skipped(sep, sv, skipper)) {
+                        sv = save;
+                        break;
+                    }
+                    impl::skip(sv, skipper);
+                    if (!impl::visit_skipped(elem, sv, skipper) || sv.size() == save.size()) {
+                        sv = save; // no progress would loop forever
+                        break;
+                    }
+                    ++n;
+                }
+                if (count) {
+                    *count = n;
+                }
+                return true;
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                return elem.first(set);
+            }
+
+            // At least the number of elements that the list can match at
+            // the front of input: one more than the places a separator
+            // matches.  A separator whose matches all start with the same
+            // byte, like a char_ or a lit_, is looked for with memchr.
+            inline std::size_t max_count(std::string_view input) const noexcept {
+                impl::byteset starts;
+                if (sep.first(starts) || starts.count() == 0) {
+                    return input.size() + 1; // separators can be empty
+                }
+                std::size_t n = 1;
+                if (starts.count() == 1) {
+                    unsigned char byte = 0;
+                    while (!starts.contains(byte))
+                        ++byte;
+                    char const* p = input.data();
+                    char const* const last = p + input.size();
+                    while (p != last) {
+                        void const* hit = std::memchr(p, byte, static_cast<std::size_t>(last - p));
+                        if (!hit) {
+                            break;
+                        }
+                        p = static_cast<char const*>(hit);
+                        std::string_view rest(p, static_cast<std::size_t>(last - p));
+                        n += sep.visit(rest, nosk);
+                        ++p;
+                    }
+                    return n;
+                }
+                for (std::size_t i = 0; i < input.size(); ++i) {
+                    std::string_view rest = input.substr(i);
+                    n += starts.contains(static_cast<unsigned char>(input[i])) && sep.visit(rest, nosk);
+                }
+                return n;
+            }
+
+        private:
+            friend struct rewrite;
+
+            Elem elem;
+            Sep sep;
+            std::size_t* count;
+        };
+
+        template <typename Parser>
+        constexpr auto as_parser(Parser&& parser) noexcept {
+            if constexpr (std::is_same_v<std::decay_t<Parser>, char>) {
+                return char_(parser);
+            } else {
+                return std::decay_t<Parser>(std::forward<Parser>(parser));
+            }
+        }
+
+        template <typename Base>
+        struct match_ final : public impl::parser_base<match_<Base>>, impl::skips_on_entry {
+            constexpr explicit match_(Base base, std::string_view& sv) noexcept
+                : base(std::move(base))
+                , out(sv)
+            {}
+
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                Input save = sv;
+                if (impl::visit_skipped(base, sv, skipper)) {
+                    out = impl::matched(save, sv);
+                    return true;
+                }
+                return false;
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                return base.first(set);
+            }
+
+        private:
+            friend struct rewrite;
+
+            Base base;
+            std::string_view& out;
+        };
+
+        template <typename Base>
+        struct match_call_ final : public impl::parser_base<match_call_<Base>>, impl::skips_on_entry {
+            constexpr explicit match_call_(Base base, std::function<void(const std::string_view&)> callback) noexcept
+                : base(std::move(base))
+                , callback(std::move(callback))
+            {}
+
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            constexpr inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                Input save = sv;
+                if (impl::visit_skipped(base, sv, skipper)) {
+                    if constexpr (std::is_same_v<Input, impl::deferred_view>) {
+                        sv.log->put(sv.count++, impl::deferred_call{ &callback, impl::matched(save, sv) });
+                    } else {
+                        callback(impl::matched(save, sv));
+                    }
                     return true;
                 }
                 return false;
             }
 
+            inline bool first(impl::byteset& set) const noexcept {
+                return base.first(set);
+            }
+
         private:
+            friend struct rewrite;
+
             Base base;
             std::function<void(const std::string_view&)> callback;
         };
 
         struct endtype_ final : public impl::parser_base<endtype_> {
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
                 return sv.empty();
             }
+
+            inline bool first(impl::byteset&) const noexcept {
+                return true;
+            }
         };
 
         struct emptytype_ final : public impl::parser_base<emptytype_> {
-            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            template <typename Input>
+            constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                return true;
+            }
+
+            inline bool first(impl::byteset&) const noexcept {
                 return true;
             }
         };
@@ -546,6 +2067,14 @@ namespace lm {
         );
     }
 
+    /// @brief The sequence parser combinator for a chain of sequences
+    /// @details `a >> b >> c` builds one flat sequence of three parsers.
+    ///     Named (lvalue) sequences are kept as a single child.
+    template <typename... Parsers, typename Right>
+    constexpr inline auto operator>>(impl::seq_<Parsers...>&& left, Right&& right) noexcept {
+        return impl::append(std::move(left), std::index_sequence_for<Parsers...>(), std::forward<Right>(right));
+    }
+
     /// @brief The alternate parser combinator
     /// @details This function combines two parsers as alternatives.  For example,
     ///     `lm::lit_("Hello") | lm::lit_("World")` parses "Hello" or "World" using
@@ -569,6 +2098,14 @@ namespace lm {
         );
     }
 
+    /// @brief The alternate parser combinator for a chain of alternatives
+    /// @details `a | b | c` builds one flat alternative of three parsers.
+    ///     Named (lvalue) alternatives are kept as a single child.
+    template <typename... Parsers, typename Right>
+    constexpr inline auto operator|(impl::alt_<Parsers...>&& left, Right&& right) noexcept {
+        return impl::append(std::move(left), std::index_sequence_for<Parsers...>(), std::forward<Right>(right));
+    }
+
     /// @brief The Kleene star or "any number of times" parser combinator
     /// @details This function returns a parser that matches its input
     ///     any number of times (including 0 times).  For example,
@@ -591,6 +2128,81 @@ namespace lm {
         return impl::plus_<Base>(*static_cast<Base const*>(this));
     }
 
+    /// @var unbounded
+    /// @brief No upper bound for `lm::repeat_`
+    constexpr std::size_t unbounded = static_cast<std::size_t>(-1);
+
+    /// @brief The bounded repetition parser combinator
+    /// @details This function returns a parser that matches its input
+    ///     from \p Min to \p Max times, as many as it can.  For example,
+    ///     `lm::repeat_<4>(lm::digit_)` matches a four digit year and
+    ///     `lm::repeat_<1, 3>(lm::digit_)` matches one to three digits.
+    ///     `lm::repeat_<0, lm::unbounded>(p)` is `*p`.
+    ///
+    ///     With an exact count, a single character base (`lm::char_`,
+    ///     `lm::range_`, `lm::digit_`) is checked 8 characters at a time
+    ///     with no loop over the parser.
+    template <std::size_t Min, std::size_t Max = Min, typename Base>
+    constexpr inline auto repeat_(Base&& base) noexcept {
+        return impl::repeat_<Min, Max, std::decay_t<Base>>(std::forward<Base>(base));
+    }
+
+    /// @brief Bounded repetition with the count known at run time
+    /// @details Matches exactly \p count of \p base, for example a field
+    ///     whose width was read from a header.
+    template <typename Base>
+    constexpr inline auto repeat_(std::size_t count, Base&& base) noexcept {
+        return impl::repeat_n_<std::decay_t<Base>>(count, count, std::forward<Base>(base));
+    }
+
+    /// @brief Bounded repetition with the bounds known at run time
+    /// @details Matches from \p min to \p max of \p base, as many as it
+    ///     can.  Pass `lm::unbounded` for no upper bound.
+    template <typename Base>
+    constexpr inline auto repeat_(std::size_t min, std::size_t max, Base&& base) noexcept {
+        return impl::repeat_n_<std::decay_t<Base>>(min, max, std::forward<Base>(base));
+    }
+
+    /// @brief The separated list parser combinator
+    /// @details This function returns a parser that matches one or more
+    ///     \p elem separated by \p sep, the same as `elem >> *(sep >> elem)`
+    ///     but with one loop and without repeating \p elem.  For example,
+    ///     `lm::list_(ident, ',')` matches "a", "a, b" and "a,b , c".  A
+    ///     separator is only consumed if an element follows it, so the
+    ///     list in "a, b," ends before the last comma.  \p sep can be a
+    ///     parser or a char.
+    ///
+    ///     `max_count(input)` on the result counts the separators in input
+    ///     with memchr when they start with one byte, which bounds the
+    ///     number of elements before parsing, to reserve storage for them.
+    ///
+    /// @param[in] elem The parser for one element
+    /// @param[in] sep The parser for the separator between two elements
+    template <typename Elem, typename Sep>
+    constexpr inline auto list_(Elem&& elem, Sep&& sep) noexcept {
+        using E = decltype(impl::as_parser(std::forward<Elem>(elem)));
+        using S = decltype(impl::as_parser(std::forward<Sep>(sep)));
+        return impl::list_<E, S>(impl::as_parser(std::forward<Elem>(elem)), impl::as_parser(std::forward<Sep>(sep)));
+    }
+
+    /// @brief The separated list parser combinator that counts the elements
+    /// @details Like `lm::list_(elem, sep)`, and when the list matches,
+    ///     \p count is set to the number of elements it matched.
+    template <typename Elem, typename Sep>
+    constexpr inline auto list_(Elem&& elem, Sep&& sep, std::size_t& count) noexcept {
+        using E = decltype(impl::as_parser(std::forward<Elem>(elem)));
+        using S = decltype(impl::as_parser(std::forward<Sep>(sep)));
+        return impl::list_<E, S>(impl::as_parser(std::forward<Elem>(elem)), impl::as_parser(std::forward<Sep>(sep)), &count);
+    }
+
+    /// @brief The separated list operator
+    /// @details `elem % sep` is `lm::list_(elem, sep)`, as in Boost.Spirit.
+    ///     For example, `lm::digit_ % lm::char_(',')` matches "1,2,3".
+    template <typename Elem, typename Sep, typename = std::enable_if_t<std::is_base_of_v<impl::parser_base<std::decay_t<Elem>>, std::decay_t<Elem>>>>
+    constexpr inline auto operator%(Elem&& elem, Sep&& sep) noexcept {
+        return list_(std::forward<Elem>(elem), std::forward<Sep>(sep));
+    }
+
     /// @brief The match operator
     /// @details This side-effect-only function copies the matched part of
     ///     input to its argument output.  If there is no match, then output
@@ -630,6 +2242,544 @@ namespace lm {
         return impl:: match_call_<Base>(*static_cast<Base const*>(this), std::move(callback));
     }
 
+    namespace impl {
+        // A single character parser for any byte of a set, one table lookup.
+        // What lm::optimize turns alternatives of character classes into.
+        struct set_ final : public impl::parser_base<set_> {
+            constexpr explicit set_(impl::byteset set) noexcept
+                : set(set)
+            {}
+
+            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                if (!sv.empty() && set.contains(static_cast<unsigned char>(sv.front()))) {
+                    sv.remove_prefix(1);
+                    return true;
+                }
+                return false;
+            }
+
+            constexpr bool test(char c) const noexcept {
+                return set.contains(static_cast<unsigned char>(c));
+            }
+
+            constexpr bool first(impl::byteset& out) const noexcept {
+                for (int i = 0; i < 4; ++i)
+                    out.bits[i] |= set.bits[i];
+                return false;
+            }
+
+        private:
+            impl::byteset set;
+        };
+
+        // N literals tried in order, like lit_ | lit_ | ..., with the prefix
+        // they all share compared once.  After it, a literal is only tried
+        // if its next byte is the next byte of the input.
+        template <std::size_t N>
+        struct lits_ final : public impl::parser_base<lits_<N>> {
+            template <std::size_t... Is>
+            constexpr lits_(std::string_view const (&head)[N - 1], std::string_view const& tail, std::index_sequence<Is...>) noexcept
+                : lits{ head[Is]..., tail }
+                , prefix(shared_prefix(lits))
+            {}
+
+            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                if (sv.size() < prefix || sv.substr(0, prefix) != lits[0].substr(0, prefix)) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < N; ++i) {
+                    std::string_view const text = lits[i];
+                    if ((text.size() == prefix || (sv.size() > prefix && sv[prefix] == text[prefix])) && starts_with(sv, text)) {
+                        sv.remove_prefix(text.size());
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            constexpr bool first(impl::byteset& set) const noexcept {
+                bool nullable = false;
+                for (std::size_t i = 0; i < N; ++i) {
+                    if (lits[i].size() == 0)
+                        nullable = true;
+                    else
+                        set.insert(static_cast<unsigned char>(lits[i].front()));
+                }
+                return nullable;
+            }
+
+        private:
+            friend struct rewrite;
+
+            static constexpr std::size_t shared_prefix(std::string_view const (&lits)[N]) noexcept {
+                std::size_t n = lits[0].size();
+                for (std::size_t i = 1; i < N; ++i) {
+                    std::size_t k = 0;
+                    while (k < n && k < lits[i].size() && lits[i][k] == lits[0][k])
+                        ++k;
+                    n = k;
+                }
+                return n;
+            }
+
+            std::string_view lits[N];
+            std::size_t prefix;
+        };
+
+        template <typename Parser>
+        constexpr bool is_char_class = std::is_same_v<Parser, char_> || std::is_same_v<Parser, charset_>
+            || std::is_same_v<Parser, char_if_> || std::is_same_v<Parser, range_> || std::is_same_v<Parser, set_>;
+
+        template <typename Parser>
+        struct is_lits : std::false_type {};
+
+        template <std::size_t N>
+        struct is_lits<lits_<N>> : std::true_type {};
+
+        template <typename T, template <typename...> class Node>
+        struct is_node : std::false_type {};
+
+        template <typename... Parsers, template <typename...> class Node>
+        struct is_node<Node<Parsers...>, Node> : std::true_type {};
+
+        // Rebuilds a grammar bottom up.  Every rule keeps what the grammar
+        // matches, and every match_, match_call_ and capture_ stays where
+        // it is, so the callbacks and captures see the same text.
+        //
+        // Skips is false inside a lexeme_.  Outside of one, a seq_ or alt_
+        // skips before its children but a character or a literal does not,
+        // so a node that would be left with one such child keeps its node
+        // around it.
+        struct rewrite {
+            // anything that is not a combinator stays as it is
+            template <bool Skips = true, typename Parser>
+            static constexpr auto apply(Parser const& parser) noexcept {
+                return parser;
+            }
+
+            template <bool Skips = true, typename... Parsers>
+            static constexpr auto apply(seq_<Parsers...> const& node) noexcept {
+                return apply_seq<Skips>(node, std::index_sequence_for<Parsers...>());
+            }
+
+            template <bool Skips = true, typename... Parsers>
+            static constexpr auto apply(alt_<Parsers...> const& node) noexcept {
+                return apply_alt<Skips>(node, std::index_sequence_for<Parsers...>());
+            }
+
+            // *(*x) is not *x: the inner loop runs again after the outer one
+            // has skipped, and the callbacks in x see the failed tries twice
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(kleene_<Base> const& node) noexcept {
+                return kleene_<decltype(apply<Skips>(node.base))>(apply<Skips>(node.base));
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(plus_<Base> const& node) noexcept {
+                return plus_<decltype(apply<Skips>(node.base))>(apply<Skips>(node.base));
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(opt_<Base> const& node) noexcept {
+                auto base = apply<Skips>(node.base);
+                using B = decltype(base);
+                // opt_(*x) and opt_(opt_(x)) are *x and opt_(x): both skip
+                // on entry and always match
+                if constexpr (is_node<B, kleene_>::value || is_node<B, opt_>::value) {
+                    return base;
+                } else {
+                    return opt_<B>(std::move(base));
+                }
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(lexeme_<Base> const& node) noexcept {
+                auto base = apply<false>(node.base);
+                using B = decltype(base);
+                // a character or a literal never skips anyway
+                if constexpr (is_node<B, lexeme_>::value || is_leaf<B>) {
+                    return base;
+                } else {
+                    return lexeme_<B>(std::move(base));
+                }
+            }
+
+            template <bool Skips = true, std::size_t Min, std::size_t Max, typename Base>
+            static constexpr auto apply(repeat_<Min, Max, Base> const& node) noexcept {
+                return repeat_<Min, Max, decltype(apply<Skips>(node.base))>(apply<Skips>(node.base));
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(repeat_n_<Base> const& node) noexcept {
+                return repeat_n_<decltype(apply<Skips>(node.base))>(node.min, node.max, apply<Skips>(node.base));
+            }
+
+            template <bool Skips = true, typename Elem, typename Sep>
+            static constexpr auto apply(list_<Elem, Sep> const& node) noexcept {
+                return list_<decltype(apply<Skips>(node.elem)), decltype(apply<Skips>(node.sep))>(
+                    apply<Skips>(node.elem), apply<Skips>(node.sep), node.count);
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(match_<Base> const& node) noexcept {
+                return match_<decltype(apply<Skips>(node.base))>(apply<Skips>(node.base), node.out);
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(match_call_<Base> const& node) noexcept {
+                return match_call_<decltype(apply<Skips>(node.base))>(apply<Skips>(node.base), node.callback);
+            }
+
+            template <bool Skips = true, typename Base>
+            static constexpr auto apply(capture_<Base> const& node) noexcept {
+                return capture_<decltype(apply<Skips>(node.base))>(node.tag, apply<Skips>(node.base));
+            }
+
+        private:
+            template <typename Parser>
+            static constexpr bool is_leaf = is_char_class<Parser> || std::is_same_v<Parser, lit_> || is_lits<Parser>::value;
+
+            // the children to put in place of child in a seq_: a seq_ is
+            // flattened into its parent and empty_ is dropped.  The seq_
+            // skips before its last child, so a trailing empty_ still eats
+            // the trailing space and stays.
+            template <bool Skips, bool Last, typename Parser>
+            static constexpr auto seq_children(Parser parser) noexcept {
+                if constexpr (std::is_same_v<Parser, emptytype_> && !(Skips && Last)) {
+                    return std::tuple<>();
+                } else if constexpr (is_node<Parser, seq_>::value) {
+                    return children(std::move(parser));
+                } else {
+                    return std::tuple<Parser>(std::move(parser));
+                }
+            }
+
+            template <typename Parser>
+            static constexpr auto alt_children(Parser parser) noexcept {
+                if constexpr (is_node<Parser, alt_>::value) {
+                    return children(std::move(parser));
+                } else {
+                    return std::tuple<Parser>(std::move(parser));
+                }
+            }
+
+            template <template <typename...> class Node, typename... Parsers>
+            static constexpr auto children(Node<Parsers...> node) noexcept {
+                return children(std::move(node), std::index_sequence_for<Parsers...>());
+            }
+
+            template <template <typename...> class Node, typename... Parsers, std::size_t... Is>
+            static constexpr auto children(Node<Parsers...> node, std::index_sequence<Is...>) noexcept {
+                return std::tuple<Parsers...>(std::move(child<Is>(node))...);
+            }
+
+            // a tuple of children as one parser.  One child that doesn't
+            // skip on entry keeps the node, which does.
+            template <template <typename...> class Node, bool Skips, typename... Parsers>
+            static constexpr auto make(std::tuple<Parsers...> parsers) noexcept {
+                if constexpr (sizeof...(Parsers) == 0) {
+                    return emptytype_();
+                } else if constexpr (sizeof...(Parsers) == 1 && (!Skips || (std::is_base_of_v<skips_on_entry, Parsers> && ...))) {
+                    return std::get<0>(std::move(parsers));
+                } else {
+                    return std::apply([](Parsers&... children) {
+                        return Node<Parsers...>(std::move(children)...);
+                    }, parsers);
+                }
+            }
+
+            template <bool Skips, typename... Parsers, std::size_t... Is>
+            static constexpr auto apply_seq(seq_<Parsers...> const& node, std::index_sequence<Is...>) noexcept {
+                return make<seq_, Skips>(std::tuple_cat(
+                    seq_children<Skips, Is + 1 == sizeof...(Parsers)>(apply<Skips>(child<Is>(node)))...));
+            }
+
+            template <bool Skips, typename... Parsers, std::size_t... Is>
+            static constexpr auto apply_alt(alt_<Parsers...> const& node, std::index_sequence<Is...>) noexcept {
+                auto parsers = std::tuple_cat(alt_children(apply<Skips>(child<Is>(node)))...);
+                return make<alt_, Skips>(std::apply([](auto&... children) {
+                    return merge(std::tuple<>(), std::move(children)...);
+                }, parsers));
+            }
+
+            // Merges each run of neighbouring alternatives that can be one
+            // parser.  Only neighbours: a | x | b is not a | b | x.
+            template <typename... Done, typename Pending>
+            static constexpr auto merge(std::tuple<Done...> done, Pending pending) noexcept {
+                return std::tuple_cat(std::move(done), std::tuple<Pending>(std::move(pending)));
+            }
+
+            template <typename... Done, typename Pending, typename Next, typename... Rest>
+            static constexpr auto merge(std::tuple<Done...> done, Pending pending, Next next, Rest... rest) noexcept {
+                if constexpr (std::is_same_v<Pending, emptytype_>) {
+                    // empty_ always matches, the rest is never tried
+                    return merge(std::move(done), std::move(pending));
+                } else if constexpr (is_char_class<Pending> && is_char_class<Next>) {
+                    impl::byteset set;
+                    pending.first(set);
+                    next.first(set);
+                    return merge(std::move(done), set_(set), std::move(rest)...);
+                } else if constexpr (std::is_same_v<Pending, lit_> && std::is_same_v<Next, lit_>) {
+                    std::string_view const head[1] = { pending.str };
+                    return merge(std::move(done), lits_<2>(head, next.str, std::make_index_sequence<1>()), std::move(rest)...);
+                } else if constexpr (is_lits<Pending>::value && std::is_same_v<Next, lit_>) {
+                    constexpr std::size_t n = sizeof(pending.lits) / sizeof(pending.lits[0]);
+                    return merge(std::move(done), lits_<n + 1>(pending.lits, next.str, std::make_index_sequence<n>()), std::move(rest)...);
+                } else {
+                    return merge(std::tuple_cat(std::move(done), std::tuple<Pending>(std::move(pending))), std::move(next), std::move(rest)...);
+                }
+            }
+        };
+    }
+
+    /// @brief Simplify a grammar
+    /// @details Returns a parser that matches the same inputs as \p parser,
+    ///     with the same callbacks and captures, but does less work:
+    ///
+    ///     - neighbouring alternatives of single characters (`lm::char_`,
+    ///       `lm::charset_`, `lm::range_`, `lm::char_if_`) become one
+    ///       table lookup, so `lm::char_('a') | lm::char_('b')` is one test
+    ///     - neighbouring alternatives of literals share the compare of
+    ///       their common prefix, so `lm::lit_("ab") | lm::lit_("ac")`
+    ///       looks at the 'a' once and then at most one literal
+    ///     - `lm::opt_(*x)` is `*x`, and `lm::empty_` in the middle of a
+    ///       sequence is dropped
+    ///     - alternatives after `lm::empty_` are dropped because they can
+    ///       never be tried
+    ///     - nested sequences and alternatives are flattened
+    ///
+    ///     The skipper still runs where it did: a sequence or alternative
+    ///     left with one character or literal keeps its node, which skips
+    ///     before it.  Inside `lm::lexeme_` nothing skips, so there
+    ///     `lm::optimize(lm::lexeme_(lm::char_('a') | lm::char_('b')))` is
+    ///     the bare table lookup.
+    ///
+    ///     Call it once when the grammar is built.  Grammars without
+    ///     callbacks can be optimized at compile time:
+    ///
+    ///         constexpr auto keyword = lm::optimize(lm::lit_("int") | lm::lit_("in") | lm::lit_("if"));
+    ///
+    ///     Alternatives are never reordered, so the first alternative that
+    ///     matches still wins.
+    ///
+    /// @param[in] parser The grammar to simplify.  Named parts of it are copied.
+    template <typename Parser>
+    constexpr inline auto optimize(Parser const& parser) noexcept {
+        return impl::rewrite::apply(parser);
+    }
+
+    namespace impl {
+        template <typename... Parsers>
+        struct adaptive_alt_;
+    }
+
+    /// @class branch_order
+    /// @brief What an `lm::adapt_` rule learned about its branches
+    /// @details Caller-provided, like `lm::capture_buffer`, so that every
+    ///     copy of the rule in a grammar (`*rule`, `rule >> x`, ...) counts
+    ///     into the same place.
+    template <std::size_t N>
+    class branch_order {
+    public:
+        /// @brief The branches from most to least matches, to freeze with `lm::reorder_`
+        constexpr std::size_t const (&order() const noexcept)[N] {
+            return tries;
+        }
+
+        /// @brief False if the branches can overlap, so they are tried in source order
+        constexpr bool adapts() const noexcept {
+            return disjoint;
+        }
+
+    private:
+        template <typename... Parsers>
+        friend struct impl::adaptive_alt_;
+
+        std::size_t tries[N] = {};
+        std::uint32_t wins[N] = {};
+        std::uint32_t matches = 0;
+        bool disjoint = false;
+    };
+
+    namespace impl {
+        // Alternatives that learn which branch matches most often.  When the
+        // FIRST sets of the branches are disjoint and none can match empty,
+        // at most one branch can match at any position, so the byte there
+        // picks the branch from a table and the wins are counted to learn
+        // the order for lm::reorder_.  Otherwise this is a plain alt_.
+        template <typename... Parsers>
+        struct adaptive_alt_ final : public impl::parser_base<adaptive_alt_<Parsers...>>, impl::skips_on_entry
+                                   , children_<std::index_sequence_for<Parsers...>, Parsers...> {
+            static_assert(sizeof...(Parsers) < 256, "adapt_ takes at most 255 branches");
+
+            explicit adaptive_alt_(branch_order<sizeof...(Parsers)>* learned, Parsers&&... parsers) noexcept
+                : children_<std::index_sequence_for<Parsers...>, Parsers...>(std::forward<Parsers>(parsers)...)
+                , learned(learned)
+            {
+                impl::byteset seen;
+                disjoint = true;
+                for (std::size_t i = 0; i < size; ++i) {
+                    impl::byteset set;
+                    disjoint = !first_at(i, set, std::index_sequence_for<Parsers...>()) && disjoint;
+                    for (unsigned ch = 0; ch < 256; ++ch) {
+                        if (set.contains(static_cast<unsigned char>(ch))) {
+                            disjoint = disjoint && !seen.contains(static_cast<unsigned char>(ch));
+                            seen.insert(static_cast<unsigned char>(ch));
+                            picks[ch] = static_cast<std::uint8_t>(i + 1);
+                        }
+                    }
+                    learned->tries[i] = i;
+                    learned->wins[i] = 0;
+                }
+                learned->matches = 0;
+                learned->disjoint = disjoint;
+            }
+
+            template <typename Input>
+            inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+                impl::skip(sv, skipper);
+                return run(sv, skipper);
+            }
+
+            template <typename Input>
+            inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+                return run(sv, skipper, std::index_sequence_for<Parsers...>());
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                bool nullable = false;
+                for (std::size_t i = 0; i < size; ++i) {
+                    nullable = first_at(i, set, std::index_sequence_for<Parsers...>()) || nullable;
+                }
+                return nullable;
+            }
+
+        private:
+            static constexpr std::size_t size = sizeof...(Parsers);
+            static constexpr std::uint32_t period = 1024;
+
+            template <std::size_t I, typename Input>
+            static bool visit_child(adaptive_alt_ const& self, Input& sv, Skipper& skipper) noexcept {
+                return impl::visit_skipped(impl::child<I>(self), sv, skipper);
+            }
+
+            // the branch that the next byte picks, through a table
+            template <typename Input, std::size_t... Is>
+            inline bool run(Input& sv, Skipper& skipper, std::index_sequence<Is...>) const noexcept {
+                if (!disjoint) {
+                    const Input save = sv;
+                    return (impl::visit_skipped(impl::child<Is>(*this), sv = save, skipper) || ...);
+                }
+                using visit_fn = bool (*)(adaptive_alt_ const&, Input&, Skipper&) noexcept;
+                static constexpr visit_fn branches[] = { &visit_child<Is, Input>... };
+                std::string_view const& text = sv;
+                const std::size_t pick = text.empty() ? 0 : picks[static_cast<unsigned char>(text.front())];
+                if (pick == 0 || !branches[pick - 1](*this, sv, skipper)) {
+                    return false;
+                }
+                won(pick - 1);
+                return true;
+            }
+
+            // add the FIRST set of child i
+            template <std::size_t... Is>
+            inline bool first_at(std::size_t i, impl::byteset& set, std::index_sequence<Is...>) const noexcept {
+                return ((i == Is && impl::child<Is>(*this).first(set)) || ...);
+            }
+
+            // every period matches, sort the branches by their wins, and
+            // halve the counts so the order follows the input as it changes
+            inline void won(std::size_t i) const noexcept {
+                std::size_t* const tries = learned->tries;
+                std::uint32_t* const wins = learned->wins;
+                ++wins[i];
+                if (++learned->matches < period) {
+                    return;
+                }
+                learned->matches = 0;
+                for (std::size_t k = 1; k < size; ++k) {
+                    const std::size_t moving = tries[k];
+                    std::size_t j = k;
+                    for (; j > 0 && wins[tries[j - 1]] < wins[moving]; --j) {
+                        tries[j] = tries[j - 1];
+                    }
+                    tries[j] = moving;
+                }
+                for (std::size_t k = 0; k < size; ++k) {
+                    wins[k] /= 2;
+                }
+            }
+
+            branch_order<sizeof...(Parsers)>* learned;
+            std::uint8_t picks[256] = {}; // the branch starting with each byte, plus one
+            bool disjoint = false;
+        };
+
+        template <std::size_t N, std::size_t... Is>
+        constexpr bool is_permutation() noexcept {
+            bool seen[N] = {};
+            for (std::size_t i : { Is... }) {
+                if (i >= N || seen[i]) {
+                    return false;
+                }
+                seen[i] = true;
+            }
+            return true;
+        }
+
+        template <typename... Parsers, std::size_t... Is>
+        inline auto adapt(alt_<Parsers...>&& alt, branch_order<sizeof...(Parsers)>& learned, std::index_sequence<Is...>) noexcept {
+            return adaptive_alt_<Parsers...>(&learned, static_cast<Parsers&&>(impl::child<Is>(alt))...);
+        }
+    }
+
+    /// @brief Alternatives that learn which branch matches most
+    /// @details Returns a parser like \p alt that counts which branch
+    ///     matches and, every 1024 matches, sorts the branches by their
+    ///     counts.  For an HTTP method rule, "GET" ends up first whatever
+    ///     order the grammar lists them in.
+    ///
+    ///     Order only stops mattering when the FIRST sets of the branches
+    ///     are disjoint and none of them can match empty: then at most one
+    ///     branch can match anywhere.  In that case the next byte of the
+    ///     input picks the only branch worth trying from a table, which is
+    ///     cheaper than trying the likeliest first.  Otherwise `adapts()`
+    ///     is false and the branches are tried in source order, like
+    ///     `operator|`.  Grammars with `lm::action_` branches don't adapt.
+    ///
+    ///     The counts go into \p learned.  Once the order has settled,
+    ///     `learned.order()` gives it, and `lm::reorder_` freezes it into
+    ///     the grammar for the next build, where a constexpr grammar can't
+    ///     use adapt_:
+    ///
+    ///         lm::branch_order<3> learned;
+    ///         auto method = lm::adapt_(lm::lit_("TRACE") | lm::lit_("POST") | lm::lit_("GET"), learned);
+    ///         ... // parse some traffic, then print learned.order(): 2 1 0
+    ///         constexpr auto frozen = lm::reorder_<2, 1, 0>(lm::lit_("TRACE") | lm::lit_("POST") | lm::lit_("GET"));
+    ///
+    ///     The counts change as it parses, so give each thread its own
+    ///     \p learned and rule.
+    ///
+    /// @param[in] alt The alternatives, built with `operator|`
+    /// @param[out] learned Receives the counts and the order.  Must outlive the parser.
+    template <typename... Parsers>
+    inline auto adapt_(impl::alt_<Parsers...> alt, branch_order<sizeof...(Parsers)>& learned) noexcept {
+        return impl::adapt(std::move(alt), learned, std::index_sequence_for<Parsers...>());
+    }
+
+    /// @brief Alternatives tried in a given order
+    /// @details `lm::reorder_<2, 0, 1>(a | b | c)` is `c | a | b`.  Use it
+    ///     to freeze the order that `lm::adapt_` learned.  Like `lm::adapt_`,
+    ///     this only matches the same inputs if the branches can't overlap.
+    template <std::size_t... Order, typename... Parsers>
+    constexpr inline auto reorder_(impl::alt_<Parsers...> alt) noexcept {
+        static_assert(impl::is_permutation<sizeof...(Parsers), Order...>(), "reorder_ takes each branch index once");
+        using branches = std::tuple<Parsers...>;
+        return impl::alt_<std::tuple_element_t<Order, branches>...>(
+            static_cast<std::tuple_element_t<Order, branches>&&>(impl::child<Order>(alt))...
+        );
+    }
+
     /// @brief The parse function
     /// @details This is the top level function you should call to evaluate
     ///     a parser with an input.
@@ -664,6 +2814,648 @@ namespace lm {
     constexpr bool parse_ref(std::string_view& input, Parser const& parser, Skipper& skipper = skws) noexcept {
         return parser.visit(input, skipper);
     }
+
+    /// @brief The parse function that records captures
+    /// @details Runs \p parser like `lm::parse` and records the matches of
+    ///     every `lm::capture_` in it into \p captures, with no allocation.
+    ///     For example:
+    ///
+    ///         lm::capture storage[64];
+    ///         lm::capture_buffer captures(storage);
+    ///         if (lm::parse(input, *lm::capture_(WORD, lm::lexeme_(+lm::alpha_)), captures))
+    ///             for (lm::capture const& c : captures)
+    ///                 use(captures.text(c));
+    ///
+    ///     Recursive rules written with `lm::action_` keep capturing if their
+    ///     callback takes `auto&` and calls `lm::parse_ref` with it.
+    ///
+    /// @param[in] input The input string to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @param[out] captures Receives the captures, replacing earlier ones
+    /// @returns true if the parser matched the input and the captures fit
+    template <typename Parser>
+    constexpr bool parse(std::string_view input, Parser const& parser, capture_buffer& captures, Skipper& skipper = skws) noexcept {
+        impl::capture_access::finish(captures, input, 0);
+        impl::capture_view sv(input, &captures);
+        const bool matched = parser.visit(sv, skipper);
+        impl::capture_access::finish(captures, input, matched ? sv.count : 0);
+        return matched && !captures.overflow();
+    }
+
+    /// @brief The parse_ref function for recursive rules that capture
+    /// @details Chosen when an `lm::action_` callback passes its `auto&`
+    ///     argument on, so the captures of the nested parse are kept.
+    template <typename Parser>
+    constexpr bool parse_ref(impl::capture_view& input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        return parser.visit(input, skipper);
+    }
+
+    /// @brief The parse function with transactional callbacks
+    /// @details Runs \p parser like `lm::parse`, but the callbacks of
+    ///     `operator[](std::function)` wait until the whole parse has
+    ///     succeeded.  A callback in a branch that is backtracked never
+    ///     runs, and if the parse fails none of them run.  They run in
+    ///     the same order as they would have right away.  For example,
+    ///
+    ///         (lm::char_('a')[fa] >> lm::char_('b')) | (lm::char_('a')[fa] >> lm::char_('e'))
+    ///
+    ///     calls fa twice on "ae" with `lm::parse` and once with
+    ///     `lm::parse_deferred`.  The pending callbacks are a pointer and
+    ///     a string_view each, and the first 32 don't allocate.
+    ///
+    ///     Recursive rules written with `lm::action_` keep deferring if
+    ///     their callback takes `auto&` and calls `lm::parse_ref` with it.
+    ///
+    /// @param[in] input The input string to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @returns true if the parser matched the input
+    template <typename Parser>
+    inline bool parse_deferred(std::string_view input, Parser const& parser, Skipper& skipper = skws) {
+        impl::action_log log;
+        impl::deferred_view sv(input, &log);
+        if (!parser.visit(sv, skipper)) {
+            return false;
+        }
+        log.run(sv.count);
+        return true;
+    }
+
+    /// @brief The parse_ref function for recursive rules that defer callbacks
+    /// @details Chosen when an `lm::action_` callback passes its `auto&`
+    ///     argument on, so the callbacks of the nested parse wait too.
+    template <typename Parser>
+    constexpr bool parse_ref(impl::deferred_view& input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        return parser.visit(input, skipper);
+    }
+
+    /// @brief The parse function that reports every step to a tracer
+    /// @details Runs \p parser like `lm::parse` and calls \p tracer on
+    ///     every visit of a parser in the grammar:
+    ///
+    ///         tracer.enter(lm::rule_info const& rule, std::size_t offset);
+    ///         tracer.exit(lm::rule_info const& rule, std::size_t begin, std::size_t end);
+    ///         tracer.fail(lm::rule_info const& rule, std::size_t begin);
+    ///
+    ///     Offsets are from the start of \p input.  The hooks only exist in
+    ///     the instantiations made for `parse_traced`, so `lm::parse` with
+    ///     the same grammar compiles exactly as before.  Instead of
+    ///     sprinkling `operator[]` over the grammar to debug it, trace it
+    ///     with one of the tracers in limn_trace.h.
+    ///
+    ///     Recursive rules written with `lm::action_` keep tracing if their
+    ///     callback takes `auto&` and calls `lm::parse_ref` with it.
+    ///
+    /// @param[in] input The input string to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @param[inout] tracer Receives the events
+    /// @returns true if the parser matched the input
+    template <typename Parser, typename Tracer>
+    inline bool parse_traced(std::string_view input, Parser const& parser, Tracer& tracer, Skipper& skipper = skws) {
+        impl::traced_view<Tracer> sv(input, &tracer);
+        return impl::visit(parser, sv, skipper);
+    }
+
+    /// @brief The parse_ref function for recursive rules that are traced
+    template <typename Parser, typename Tracer>
+    inline bool parse_ref(impl::traced_view<Tracer>& input, Parser const& parser, Skipper& skipper = skws) {
+        return impl::visit(parser, input, skipper);
+    }
+
+    /// @brief The parse function with bounded work
+    /// @details Runs \p parser like `lm::parse`, but gives up with
+    ///     `parse_result::out_of_steps` once it has visited more parsers
+    ///     than \p bounds allows, and with `parse_result::too_deep` if the
+    ///     visits nest deeper than that.  A bad input then costs at most
+    ///     the budget, whatever the grammar does with it:
+    ///
+    ///         switch (lm::parse(request, grammar, lm::limits{ 100000, 200 })) {
+    ///         case lm::parse_result::matched: ...
+    ///         case lm::parse_result::no_match: ...
+    ///         default: // reject the request
+    ///         }
+    ///
+    ///     Each visit costs a decrement and a compare.  Recursive rules
+    ///     written with `lm::action_` keep counting if their callback takes
+    ///     `auto&` and calls `lm::parse_ref` with it.  A callback that takes
+    ///     `std::string_view&` would drop the limits, so it doesn't compile.
+    ///
+    /// @param[in] input The input string to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @param[in] bounds The most steps and the deepest nesting allowed
+    /// @returns whether it matched, or which limit stopped it
+    template <typename Parser>
+    constexpr parse_result parse(std::string_view input, Parser const& parser, limits const& bounds, Skipper& skipper = skws) noexcept {
+        impl::budget left{ bounds.steps, bounds.depth };
+        impl::budget_view sv(input, &left);
+        const bool matched = impl::visit(parser, sv, skipper);
+        if (left.stop != parse_result::matched) {
+            return left.stop;
+        }
+        return matched ? parse_result::matched : parse_result::no_match;
+    }
+
+    /// @brief The parse_ref function for recursive rules with limits
+    /// @details Returns false when a limit is hit, and the outer
+    ///     `lm::parse` reports which one.
+    template <typename Parser>
+    constexpr bool parse_ref(impl::budget_view& input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        return impl::visit(parser, input, skipper);
+    }
+
+    /// @brief The parse function for padded input
+    /// @details Runs \p parser like `lm::parse`, but the repetitions of
+    ///     character classes and the literals read past the end of the
+    ///     input into its padding instead of checking for the end.  See
+    ///     `lm::padded`.
+    ///
+    /// @param[in] input The input string to parse, with its padding
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @returns true if the parser matched the input or false otherwise
+    template <typename Parser>
+    constexpr bool parse(padded input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        impl::padded_view sv(input.text);
+        return parser.visit(sv, skipper);
+    }
+
+    /// @brief The parse_ref function for recursive rules over padded input
+    template <typename Parser>
+    constexpr bool parse_ref(impl::padded_view& input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        return parser.visit(input, skipper);
+    }
+
+    /// @brief The parse function for token input
+    /// @details Evaluates a token-level parser (built from `lm::tok_`,
+    ///     `lm::kw_` and the usual combinators) on the output of
+    ///     `lm::lexer_::tokenize`.  There is no skipper because the lexer
+    ///     already dropped the whitespace.
+    ///
+    /// @param[in] input The tokens to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @returns true if the parser matched the input or false otherwise
+    template <typename Parser>
+    constexpr bool parse(token_stream input, Parser const& parser) noexcept {
+        return parser.visit(input, nosk);
+    }
+
+    /// @class searcher_
+    /// @brief Finds the matches of a parser anywhere in its input
+    /// @details `lm::parse` only matches at the start of the input.  A
+    ///     searcher_ looks for matches of \p parser at every position, from
+    ///     left to right, without overlaps.  It works out the FIRST set of
+    ///     the grammar (the bytes a match can start with) once, then jumps
+    ///     straight to those bytes, with memchr when there is only one of
+    ///     them.  The parser is only tried there.  For example:
+    ///
+    ///         lm::searcher_ finder(lm::lit_("GET ") >> +lm::graph_);
+    ///         std::string_view match;
+    ///         while (finder.next(log, match))
+    ///             ... // match is "GET /index.html", etc
+    ///
+    ///     Empty matches are never reported.  A grammar with an `lm::action_`
+    ///     in front has no known FIRST set, so it is tried everywhere.
+    template <typename Parser>
+    struct searcher_ final {
+        /// @brief Construct a searcher_
+        /// @param[in] parser The parser to look for
+        explicit searcher_(Parser parser) noexcept
+            : parser(std::move(parser))
+        {
+            this->parser.first(starts);
+            count = starts.count();
+            for (unsigned ch = 0; ch < 256; ++ch)
+                if (starts.contains(static_cast<unsigned char>(ch)))
+                    single = static_cast<unsigned char>(ch);
+        }
+
+        /// @brief Find the next match
+        /// @param[inout] input The text to search.  On success it is
+        ///     advanced past the match, otherwise it is left empty.
+        /// @param[out] match Set to the matched text on success
+        /// @param[in] skipper Skips whitespace inside the grammar.  The
+        ///     match starts at a byte that can start the grammar, but it
+        ///     ends wherever the grammar stopped, which can be after
+        ///     skipped text: `lm::lit_("a") >> lm::opt_(lm::lit_("zz"))`
+        ///     finds "a " in "a b".  Search with `lm::nosk` for matches
+        ///     that end at their last token.
+        /// @returns true if a match was found
+        inline bool next(std::string_view& input, std::string_view& match, Skipper& skipper = skws) const noexcept {
+            while (candidate(input)) {
+                std::string_view sv = input;
+                if (impl::visit_skipped(parser, sv, skipper) && sv.size() != input.size()) {
+                    match = impl::matched(input, sv);
+                    input = sv;
+                    return true;
+                }
+                input.remove_prefix(1);
+            }
+            return false;
+        }
+
+    private:
+        // drop the bytes that can't start a match
+        inline bool candidate(std::string_view& input) const noexcept {
+            if (count == 1) {
+                void const* found = input.empty() ? nullptr : std::memchr(input.data(), single, input.size());
+                input.remove_prefix(found ? static_cast<char const*>(found) - input.data() : input.size());
+            } else if (count != 256) {
+                std::size_t i = 0;
+                while (i < input.size() && !starts.contains(static_cast<unsigned char>(input[i])))
+                    ++i;
+                input.remove_prefix(i);
+            }
+            return !input.empty();
+        }
+
+        Parser parser;
+        impl::byteset starts;
+        std::size_t count = 0;
+        unsigned char single = 0;
+    };
+
+    /// @brief Find every match of a parser in \p input
+    /// @details Calls \p on_match with each match, from left to right and
+    ///     without overlaps, as `lm::searcher_` finds them.  For example,
+    ///     `lm::find_all(source, lm::lit_("TODO") >> +!lm::char_('\n'), print)`
+    ///     prints every TODO comment in source.
+    ///
+    /// @param[in] input The text to search
+    /// @param[in] parser The parser to look for
+    /// @param[in] on_match Called with each matched `std::string_view`
+    /// @param[in] skipper Skips whitespace inside the grammar
+    /// @returns the number of matches
+    template <typename Parser, typename Callback>
+    inline std::size_t find_all(std::string_view input, Parser const& parser, Callback&& on_match, Skipper& skipper = skws) {
+        searcher_<Parser const&> const finder(parser);
+        std::size_t found = 0;
+        std::string_view match;
+        while (finder.next(input, match, skipper)) {
+            on_match(match);
+            ++found;
+        }
+        return found;
+    }
+
+    /// @class recover_
+    /// @brief Skips what its parser can't match, up to a sync token
+    /// @details One bad record makes a whole parse fail.  Inside a
+    ///     recover_, it doesn't: when \p base fails, the input is scanned
+    ///     for the next match of \p sync (with memchr when it starts with
+    ///     one byte, as `lm::searcher_` does), the text before that is
+    ///     added to \p errors, and the parse goes on after the sync token.
+    ///     If there is no sync token, the rest of the input is the error.
+    ///     So one pass gives every good record and every bad region:
+    ///
+    ///         std::vector<std::string_view> errors;
+    ///         lm::parse(input, *lm::recover_(record >> lm::char_('\n'), lm::char_('\n'), errors) >> lm::end_);
+    ///
+    ///     recover_ only fails at the end of the input.  When the sync
+    ///     token is right where \p base failed, as on a blank line above,
+    ///     it is skipped and nothing is recorded, so every error has text.
+    ///     Errors are recorded as they are found and are not dropped if an
+    ///     outer parser backtracks, so put recover_ around the records at
+    ///     the top of the grammar.  Recording an error can allocate, and
+    ///     a `std::bad_alloc` there ends the program with `std::terminate`
+    ///     because the parse is noexcept; reserve \p errors up front when
+    ///     that matters.
+    template <typename Base, typename Sync>
+    struct recover_ final : public impl::parser_base<recover_<Base, Sync>>, impl::skips_on_entry {
+        /// @brief Construct a recover_ parser
+        /// @param[in] base The parser to match
+        /// @param[in] sync Where to start again after \p base fails
+        /// @param[out] errors Receives the skipped text of each failure
+        recover_(Base base, Sync sync, std::vector<std::string_view>& errors) noexcept
+            : base(std::move(base))
+            , sync(std::move(sync))
+            , errors(&errors)
+        {}
+
+        template <typename Input>
+        constexpr inline bool visit(Input& sv, Skipper& skipper) const& noexcept {
+            impl::skip(sv, skipper);
+            return run(sv, skipper);
+        }
+
+        template <typename Input>
+        inline bool run(Input& sv, Skipper& skipper) const& noexcept {
+            const Input save = sv;
+            if (impl::visit_skipped(base, sv, skipper)) {
+                return true;
+            }
+            sv = save;
+            if (sv.empty()) {
+                return false;
+            }
+            std::string_view rest = sv;
+            std::string_view token;
+            if (!sync.next(rest, token, nosk)) {
+                token = rest; // empty, at the end
+            }
+            // a sync token right here, like a blank line, has no bad text
+            if (token.data() != sv.data()) {
+                errors->push_back(sv.substr(0, static_cast<std::size_t>(token.data() - sv.data())));
+            }
+            sv.remove_prefix(sv.size() - rest.size());
+            return true;
+        }
+
+        // matches anything but the end
+        inline bool first(impl::byteset& set) const noexcept {
+            set.insert_all();
+            return base.first(set);
+        }
+
+    private:
+        Base base;
+        searcher_<Sync> sync;
+        std::vector<std::string_view>* errors;
+    };
+
+    /// @class dispatcher_
+    /// @brief Finds which of several grammars matches an input
+    /// @details Does what `parse(x, g0) || parse(x, g1) || ...` does, but
+    ///     returns the index of the grammar that matched and only tries the
+    ///     grammars that can start with the input's first byte.  The FIRST
+    ///     sets of the grammars are combined once into a table from byte to
+    ///     grammars, so routing a message costs one or two lookups and the
+    ///     grammars that share its first byte, however many there are:
+    ///
+    ///         lm::dispatcher_ route(lm::lit_("GET ") >> path, lm::lit_("POST ") >> path, lm::lit_("PING"));
+    ///         const std::size_t kind = route.parse(message);
+    ///         if (kind == route.npos)
+    ///             ... // no grammar matched
+    ///
+    ///     The grammars are tried in order, so the first one to match wins,
+    ///     as with `||`.  A grammar that can match empty, or has an
+    ///     `lm::action_` in front, is tried on every input.  At most 64
+    ///     grammars.
+    template <typename... Grammars>
+    struct dispatcher_ final {
+        static_assert(sizeof...(Grammars) <= 64, "a dispatcher_ holds at most 64 grammars");
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// @brief Construct a dispatcher_
+        /// @param[in] grammars The grammars to route between, in order
+        explicit dispatcher_(Grammars... grammars) noexcept
+            : grammars(std::move(grammars)...)
+        {
+            add(std::index_sequence_for<Grammars...>());
+        }
+
+        /// @brief The index of the first grammar that matches \p input, or npos
+        inline std::size_t parse(std::string_view input, Skipper& skipper = skws) const noexcept {
+            std::uint64_t candidates = at(input);
+            // a grammar that skips first can start after the skipped text
+            std::string_view skipped = input;
+            if (impl::skip(skipped, skipper) && skipped.size() != input.size()) {
+                candidates |= at(skipped);
+            }
+            return run(input, candidates, skipper, std::index_sequence_for<Grammars...>());
+        }
+
+    private:
+        // try the candidates in order, up to the first match
+        template <std::size_t... Is>
+        inline std::size_t run(std::string_view input, std::uint64_t candidates, Skipper& skipper, std::index_sequence<Is...>) const noexcept {
+            std::size_t found = npos;
+            std::string_view sv;
+            (((candidates >> Is & 1) != 0 && std::get<Is>(grammars).visit(sv = input, skipper) && (found = Is, true)) || ...);
+            return found;
+        }
+
+        template <std::size_t... Is>
+        void add(std::index_sequence<Is...>) noexcept {
+            (add(Is, std::get<Is>(grammars)), ...);
+        }
+
+        template <typename Grammar>
+        void add(std::size_t index, Grammar const& grammar) noexcept {
+            const std::uint64_t bit = std::uint64_t(1) << index;
+            impl::byteset starts;
+            const bool nullable = grammar.first(starts);
+            for (unsigned ch = 0; ch < 256; ++ch) {
+                if (nullable || starts.contains(static_cast<unsigned char>(ch))) {
+                    table[ch] |= bit;
+                }
+            }
+            if (nullable) {
+                table[256] |= bit;
+            }
+        }
+
+        // the grammars that can match input, by its first byte
+        inline std::uint64_t at(std::string_view input) const noexcept {
+            return table[input.empty() ? 256 : static_cast<unsigned char>(input.front())];
+        }
+
+        std::tuple<Grammars...> grammars;
+        std::uint64_t table[257] = {}; // the last entry is for empty input
+    };
+
+    /// @class token_def_
+    /// @brief One rule of a `lm::lexer_`
+    /// @details Pairs a token kind with the character parser that
+    ///     recognizes it.  The parser always runs without a skipper.
+    template <typename Parser>
+    struct token_def_ final {
+        /// @brief Construct a token_def_
+        /// @param[in] kind The kind given to tokens matched by \p parser
+        /// @param[in] parser The parser for the token text
+        constexpr token_def_(std::uint16_t kind, Parser parser) noexcept
+            : kind(kind)
+            , parser(std::move(parser))
+        {}
+
+        // lex one token from the front of sv into tok
+        inline bool lex(std::string_view& sv, std::string_view source, token& tok) const noexcept {
+            const std::string_view save = sv;
+            if (parser.visit(sv, nosk) && sv.size() != save.size()) { // empty tokens would never advance
+                tok.offset = static_cast<std::uint32_t>(save.data() - source.data());
+                tok.length = static_cast<std::uint32_t>(save.size() - sv.size());
+                tok.kind = kind;
+                return true;
+            }
+            sv = save;
+            return false;
+        }
+
+    private:
+        std::uint16_t kind;
+        Parser parser;
+    };
+
+    /// @class lexer_
+    /// @brief Turns characters into tokens in one linear pass
+    /// @details The rules are tried in order at each position and the first
+    ///     one that matches wins, so list keywords before identifiers if they
+    ///     need their own kind.  Usually they don't: `lm::kw_` matches on the
+    ///     token text.  For example:
+    ///
+    ///         constexpr auto lex = lm::lexer_(
+    ///             lm::token_def_(IDENT, lm::alpha_ >> *lm::alnum_),
+    ///             lm::token_def_(PUNCT, lm::charset_("<>(),;")));
+    ///         lm::token buffer[64];
+    ///         lm::token_stream tokens(input, buffer, buffer);
+    ///         if (lex.tokenize(input, buffer, 64, tokens))
+    ///             lm::parse(tokens, lm::kw_("template") >> lm::kw_("<") >> ...);
+    template <typename... Defs>
+    struct lexer_ final {
+        constexpr explicit lexer_(Defs... defs) noexcept
+            : defs(std::move(defs)...)
+        {}
+
+        /// @brief Tokenize \p input
+        /// @param[in] input The text to tokenize
+        /// @param[out] out The array that receives the tokens
+        /// @param[in] capacity The size of \p out
+        /// @param[out] tokens Set to the tokens on success
+        /// @param[in] skipper Skips the text between tokens
+        /// @returns false if some input matched no rule or \p out was too small
+        inline bool tokenize(std::string_view input, token* out, std::size_t capacity, token_stream& tokens, Skipper& skipper = skws) const noexcept {
+            std::string_view sv = input;
+            std::size_t count = 0;
+            for (skipper.skip(sv); !sv.empty(); skipper.skip(sv)) {
+                if (count == capacity) {
+                    return false;
+                }
+                token& tok = out[count];
+                const bool lexed = std::apply([&](auto const&... def) noexcept {
+                    return (def.lex(sv, input, tok) || ...);
+                }, defs);
+                if (!lexed) {
+                    return false;
+                }
+                ++count;
+            }
+            tokens = token_stream(input, out, out + count);
+            return true;
+        }
+
+    private:
+        std::tuple<Defs...> defs;
+    };
+
+    namespace impl {
+        // The offsets just after each '\n' in text, from offset base on.
+        // Words without a newline, the common case, are skipped 8 bytes at
+        // a time with the zero byte test on (word ^ "\n\n\n...").
+        inline void newline_ends(std::string_view text, std::size_t base, std::vector<std::size_t>& out) {
+            constexpr std::uint64_t ones = 0x0101010101010101u;
+            constexpr std::uint64_t high = 0x8080808080808080u;
+            char const* p = text.data();
+            const std::size_t n = text.size();
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const std::uint64_t x = load_u64(p + i) ^ (ones * '\n');
+                if (((x - ones) & ~x & high) == 0) {
+                    continue;
+                }
+                for (std::size_t j = i; j < i + 8; ++j) {
+                    if (p[j] == '\n') {
+                        out.push_back(base + j + 1);
+                    }
+                }
+            }
+            for (; i < n; ++i) {
+                if (p[i] == '\n') {
+                    out.push_back(base + i + 1);
+                }
+            }
+        }
+    }
+
+    /// @struct position
+    /// @brief A line and column, both counted from 1
+    /// @details The column counts bytes, so a tab or a UTF-8 sequence
+    ///     before it counts as one column per byte.
+    struct position {
+        std::size_t line;
+        std::size_t column;
+    };
+
+    /// @class line_index
+    /// @brief Turns offsets into the input, or matched string_views, into lines and columns
+    /// @details Nothing is done until the first lookup, so a parse that
+    ///     never reports an error pays nothing.  The first lookup finds
+    ///     every newline once, 8 bytes at a time, and every lookup after
+    ///     that is a binary search over the line starts:
+    ///
+    ///         lm::line_index lines(input);
+    ///         for (lm::capture const& c : captures) {
+    ///             lm::position at = lines.locate(captures.text(c));
+    ///             std::printf("%zu:%zu\n", at.line, at.column);
+    ///         }
+    ///
+    ///     A line ends after "\n", so "\r\n" works too, with the "\r"
+    ///     counted as the last column of its line.  The lazy build is not
+    ///     thread safe; call build() first to share one index between
+    ///     threads.
+    class line_index {
+    public:
+        /// @param[in] source The input that offsets and matches refer to
+        explicit line_index(std::string_view source) noexcept
+            : source(source)
+        {}
+
+        /// @brief Index the newlines now instead of at the first lookup
+        void build() const {
+            if (!built) {
+                starts.push_back(0);
+                impl::newline_ends(source, 0, starts);
+                built = true;
+            }
+        }
+
+        /// @brief The number of lines; the text after the last newline is a line too
+        std::size_t lines() const {
+            build();
+            return starts.size();
+        }
+
+        /// @brief The line and column of \p offset, which can be source.size()
+        position locate(std::size_t offset) const {
+            build();
+            if (offset > source.size()) {
+                offset = source.size();
+            }
+            // the last line start <= offset
+            std::size_t lo = 0;
+            std::size_t hi = starts.size();
+            while (hi - lo > 1) {
+                const std::size_t mid = lo + (hi - lo) / 2;
+                if (starts[mid] <= offset) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            return position{ lo + 1, offset - starts[lo] + 1 };
+        }
+
+        /// @brief The line and column where \p match starts
+        /// @details \p match must be a view into source, like the ones
+        ///     `operator[](std::string_view&)` and captures produce.
+        position locate(std::string_view match) const {
+            return locate(static_cast<std::size_t>(match.data() - source.data()));
+        }
+
+        /// @brief The text of line \p line (from 1), without its newline
+        std::string_view line(std::size_t line) const {
+            build();
+            if (line == 0 || line > starts.size()) {
+                return std::string_view();
+            }
+            const std::size_t begin = starts[line - 1];
+            const std::size_t end = line < starts.size() ? starts[line] - 1 : source.size();
+            return source.substr(begin, end - begin);
+        }
+
+        std::string_view source;
+
+    private:
+        mutable std::vector<std::size_t> starts;
+        mutable bool built = false;
+    };
 }
 
 #ifndef _MSC_VER
@@ -0,0 +1,452 @@
+/// @file limn_csv.h
+/// @author Joseph Malle
+/// @brief Columnar CSV/TSV reader built on Limn
+/// @details Splits delimited text into columns.  Each column is one
+///     contiguous array of field offsets into the input, not rows of
+///     strings, and each column can be checked with a Limn grammar:
+///
+///         lm::csv::reader reader;
+///         reader.field(0, lm::lexeme_(+lm::alpha_)).field(1, lm::lexeme_(+lm::digit_));
+///         lm::csv::table table;
+///         lm::csv::error err;
+///         if (reader.read(input, table, &err) == lm::csv::result::ok) {
+///             std::vector<std::int64_t> ages;
+///             table.to_int64(1, ages);
+///         }
+///
+///     Quoting follows RFC 4180: a field in quotes may hold delimiters
+///     and newlines, and a quote inside it is written twice.  Lines end
+///     with "\n" or "\r\n".
+///
+///     The delimiters, newlines and quotes are found 64 bytes at a time
+///     with SSE2 compares into bitmasks.  Whether a byte is inside quotes
+///     is the parity of the quotes before it, a prefix XOR of the quote
+///     mask, so no byte is looked at twice.  With several threads, each
+///     chunk of the input first counts its quotes, which tells the next
+///     chunk whether it starts inside quotes, and then the chunks are
+///     indexed in parallel.
+
+#pragma once
+
+#include "limn.h"
+
+#include <charconv>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIMN_CSV_SSE2 1
+#endif
+
+namespace lm {
+    namespace csv {
+
+        /// @struct dialect
+        struct dialect {
+            char delimiter = ',';  ///< '\t' for TSV
+            char quote = '"';
+            bool header = false;   ///< the first row names the columns
+        };
+
+        /// @struct field
+        /// @brief Where a field is in the input
+        /// @details For a quoted field, the text between the quotes.
+        struct field {
+            std::uint32_t offset;
+            std::uint32_t length : 31;
+            std::uint32_t escaped : 1;  ///< has doubled quotes, see `table::value`
+        };
+
+        /// @brief The outcome of a read
+        enum class result {
+            ok,
+            unterminated_quote,  ///< the input ends inside quotes
+            bad_quote,           ///< a quote in an unquoted field, or text after a closing quote
+            ragged_row,          ///< a row with a different number of fields than the first
+            invalid_field,       ///< a field that its column's grammar rejects
+            too_large            ///< inputs are limited to 2GB
+        };
+
+        /// @struct error
+        /// @brief Where a read failed
+        struct error {
+            result code = result::ok;
+            std::size_t row = 0;     ///< counting from 0, the header is not a row
+            std::size_t column = 0;
+        };
+
+        /// @class table
+        /// @brief The columns of a delimited file
+        /// @details Refers into the input, which must outlive it.
+        class table {
+        public:
+            std::size_t rows() const noexcept { return cols.empty() ? 0 : cols[0].size(); }
+            std::size_t columns() const noexcept { return cols.size(); }
+
+            /// @brief The fields of column \p c, one per row
+            std::vector<field> const& column(std::size_t c) const noexcept { return cols[c]; }
+
+            /// @brief The text of \p f, still with doubled quotes if it has any
+            std::string_view raw(field const& f) const noexcept {
+                return source.substr(f.offset, f.length);
+            }
+
+            /// @brief The value of \p f, with doubled quotes made single
+            std::string value(field const& f) const {
+                std::string out;
+                value(f, out);
+                return out;
+            }
+
+            /// @brief The value of \p f into \p out, to reuse its storage
+            void value(field const& f, std::string& out) const {
+                std::string_view text = raw(f);
+                out.clear();
+                if (!f.escaped) {
+                    out.assign(text);
+                    return;
+                }
+                for (std::size_t i = 0; i < text.size(); ++i) {
+                    out += text[i];
+                    if (text[i] == quote && i + 1 < text.size() && text[i + 1] == quote)
+                        ++i;
+                }
+            }
+
+            /// @brief Column \p c as integers
+            /// @returns false, with \p out holding the rows before it, at
+            ///     the first field that isn't an integer
+            bool to_int64(std::size_t c, std::vector<std::int64_t>& out) const {
+                return convert(c, out);
+            }
+
+            /// @brief Column \p c as floating point numbers
+            bool to_double(std::size_t c, std::vector<double>& out) const {
+                return convert(c, out);
+            }
+
+            /// @brief The input of the last read
+            std::string_view source;
+            /// @brief The header fields, if the dialect has a header
+            std::vector<field> names;
+
+        private:
+            friend class reader;
+
+            template <typename T>
+            bool convert(std::size_t c, std::vector<T>& out) const {
+                out.clear();
+                out.reserve(rows());
+                for (field const& f : cols[c]) {
+                    std::string_view const text = raw(f);
+                    T value{};
+                    auto const [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+                    if (ec != std::errc() || end != text.data() + text.size())
+                        return false;
+                    out.push_back(value);
+                }
+                return true;
+            }
+
+            std::vector<std::vector<field>> cols;
+            char quote = '"';
+        };
+
+        namespace impl {
+            // the bits of a 64 byte block that are inside quotes, given the
+            // quote bits.  Bit i is the parity of the quotes at 0..i
+            inline std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+                x ^= x << 1;
+                x ^= x << 2;
+                x ^= x << 4;
+                x ^= x << 8;
+                x ^= x << 16;
+                x ^= x << 32;
+                return x;
+            }
+
+            // bit i set if p[i] == ch, for the 64 bytes at p
+            inline std::uint64_t equal_mask(char const* p, char ch) noexcept {
+#ifdef LIMN_CSV_SSE2
+                __m128i const c = _mm_set1_epi8(ch);
+                std::uint64_t mask = 0;
+                for (int i = 0; i < 4; ++i) {
+                    __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16 * i));
+                    mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, c)))) << (16 * i);
+                }
+                return mask;
+#else
+                std::uint64_t mask = 0;
+                for (int i = 0; i < 64; ++i)
+                    mask |= static_cast<std::uint64_t>(p[i] == ch) << i;
+                return mask;
+#endif
+            }
+
+            // Appends the offsets of the delimiters and newlines outside
+            // quotes in [begin, end) to out.  inside says whether begin is
+            // inside quotes, and is updated to whether end is.
+            inline void index_chunk(std::string_view input, std::size_t begin, std::size_t end, dialect const& d,
+                                    bool& inside, std::vector<std::uint32_t>& out) {
+                char buffer[64];
+                std::uint64_t carry = inside ? ~std::uint64_t(0) : 0;
+                for (std::size_t at = begin; at < end; at += 64) {
+                    char const* p = input.data() + at;
+                    std::size_t const n = end - at < 64 ? end - at : 64;
+                    std::uint64_t valid = ~std::uint64_t(0);
+                    if (n < 64) {
+                        // the tail, copied so the loads stay in bounds
+                        std::memset(buffer, 0, sizeof(buffer));
+                        std::memcpy(buffer, p, n);
+                        p = buffer;
+                        valid = (std::uint64_t(1) << n) - 1;
+                    }
+                    std::uint64_t const quotes = equal_mask(p, d.quote) & valid;
+                    std::uint64_t const in_quotes = prefix_xor(quotes) ^ carry;
+                    carry = (in_quotes >> 63) ? ~std::uint64_t(0) : 0;
+                    std::uint64_t structural = (equal_mask(p, d.delimiter) | equal_mask(p, '\n')) & ~in_quotes & valid;
+                    while (structural) {
+                        out.push_back(static_cast<std::uint32_t>(at + lm::impl::ctz64(structural)));
+                        structural &= structural - 1;
+                    }
+                }
+                inside = carry != 0;
+            }
+
+            // true if [begin, end) has an odd number of quotes
+            inline bool odd_quotes(std::string_view input, std::size_t begin, std::size_t end, char quote) noexcept {
+                std::size_t count = 0;
+                std::size_t at = begin;
+                for (; at + 64 <= end; at += 64)
+                    count += lm::impl::popcount64(equal_mask(input.data() + at, quote));
+                for (; at < end; ++at)
+                    count += input[at] == quote;
+                return count & 1;
+            }
+        }
+
+        /// @brief Find the delimiters and newlines that are outside quotes
+        /// @details The index that `lm::csv::reader` splits fields with.
+        ///     With \p threads above 1, the input is split into that many
+        ///     chunks that are indexed in parallel.
+        /// @param[in] input The delimited text
+        /// @param[in] d The delimiter and quote
+        /// @param[out] out The offsets, in order
+        /// @param[in] threads How many threads to use
+        /// @returns `result::ok`, `result::unterminated_quote` or `result::too_large`
+        inline result index(std::string_view input, dialect const& d, std::vector<std::uint32_t>& out, unsigned threads = 1) {
+            out.clear();
+            if (input.size() > 0x7fffffffu)
+                return result::too_large;
+            std::size_t const chunk = ((input.size() / (threads ? threads : 1)) + 63) & ~std::size_t(63);
+            if (threads <= 1 || chunk < (std::size_t(1) << 16)) {
+                bool inside = false;
+                out.reserve(input.size() / 8);
+                impl::index_chunk(input, 0, input.size(), d, inside, out);
+                return inside ? result::unterminated_quote : result::ok;
+            }
+
+            // 64 byte aligned chunks.  Counting the quotes of each chunk
+            // resolves the quoted regions, so every chunk knows whether it
+            // starts inside quotes before it is indexed
+            std::size_t const count = (input.size() + chunk - 1) / chunk;
+            std::vector<unsigned char> odd(count);
+            std::vector<std::vector<std::uint32_t>> parts(count);
+            auto parallel = [&](auto&& work) {
+                std::vector<std::thread> pool;
+                for (std::size_t i = 1; i < count; ++i)
+                    pool.emplace_back(work, i);
+                work(0);
+                for (std::thread& t : pool)
+                    t.join();
+            };
+            auto bounds = [&](std::size_t i) {
+                return std::pair<std::size_t, std::size_t>(i * chunk, std::min(input.size(), (i + 1) * chunk));
+            };
+            parallel([&](std::size_t i) {
+                odd[i] = impl::odd_quotes(input, bounds(i).first, bounds(i).second, d.quote);
+            });
+            std::vector<unsigned char> starts_inside(count + 1);
+            for (std::size_t i = 0; i < count; ++i)
+                starts_inside[i + 1] = starts_inside[i] ^ odd[i];
+            parallel([&](std::size_t i) {
+                bool inside = starts_inside[i];
+                parts[i].reserve(chunk / 8);
+                impl::index_chunk(input, bounds(i).first, bounds(i).second, d, inside, parts[i]);
+            });
+
+            std::size_t total = 0;
+            for (auto const& part : parts)
+                total += part.size();
+            out.reserve(total);
+            for (auto const& part : parts)
+                out.insert(out.end(), part.begin(), part.end());
+            return starts_inside[count] ? result::unterminated_quote : result::ok;
+        }
+
+        /// @class reader
+        /// @brief Reads delimited text into a `lm::csv::table`
+        class reader {
+        public:
+            explicit reader(dialect d = {}) noexcept
+                : d(d)
+            {}
+
+            /// @brief Check the fields of column \p c with a Limn grammar
+            /// @details A field is valid if \p parser matches all of its
+            ///     value, without skipping whitespace.
+            template <typename Parser>
+            reader& field(std::size_t c, Parser parser) {
+                if (grammars.size() <= c)
+                    grammars.resize(c + 1);
+                grammars[c] = [parser](std::string_view sv) {
+                    return lm::parse(sv, parser >> end_, nosk);
+                };
+                return *this;
+            }
+
+            /// @brief Index the input with \p n threads
+            reader& threads(unsigned n) noexcept {
+                thread_count = n;
+                return *this;
+            }
+
+            /// @brief Read \p input into \p out
+            /// @param[in] input The delimited text.  Must outlive \p out.
+            /// @param[out] out The columns
+            /// @param[out] err Where it failed, if not null
+            result read(std::string_view input, table& out, error* err = nullptr) const {
+                error e;
+                e.code = read(input, out, e);
+                if (err)
+                    *err = e;
+                return e.code;
+            }
+
+        private:
+            result read(std::string_view input, table& out, error& err) const {
+                out.source = input;
+                out.quote = d.quote;
+                out.cols.clear();
+                out.names.clear();
+                std::vector<std::uint32_t> structural;
+                result const r = index(input, d, structural, thread_count);
+                if (r != result::ok)
+                    return r;
+
+                // the last line may have no newline
+                if (!input.empty() && input.back() != '\n')
+                    structural.push_back(static_cast<std::uint32_t>(input.size()));
+
+                std::vector<lm::csv::field> row;
+                std::size_t begin = 0;
+                std::size_t c = 0;
+                bool first = true;
+                for (std::uint32_t const end : structural) {
+                    bool const newline = end == input.size() || input[end] == '\n';
+                    lm::csv::field f{};
+                    if (!split(input, begin, end, newline, f)) {
+                        err.column = c;
+                        return result::bad_quote;
+                    }
+                    begin = end + 1;
+                    if (first) {
+                        // the first row sets the number of columns
+                        row.push_back(f);
+                        if (!newline)
+                            continue;
+                        first = false;
+                        err.row += !d.header;
+                        if (d.header) {
+                            out.names = std::move(row);
+                            out.cols.resize(out.names.size());
+                        } else {
+                            out.cols.resize(row.size());
+                            for (std::size_t i = 0; i < row.size(); ++i)
+                                out.cols[i].push_back(row[i]);
+                        }
+                        for (auto& col : out.cols)
+                            col.reserve(structural.size() / out.cols.size() + 1);
+                        continue;
+                    }
+                    if (c == out.cols.size()) {
+                        err.column = c;
+                        return result::ragged_row;
+                    }
+                    out.cols[c].push_back(f);
+                    if (newline) {
+                        if (c + 1 != out.cols.size()) {
+                            err.column = c;
+                            return result::ragged_row;
+                        }
+                        c = 0;
+                        ++err.row;
+                    } else {
+                        ++c;
+                    }
+                }
+                err.row = 0;
+                return validate(out, err);
+            }
+
+            // the field in [begin, end), without a "\r" before a newline
+            // and without its quotes
+            bool split(std::string_view input, std::size_t begin, std::size_t end, bool newline, lm::csv::field& f) const noexcept {
+                if (newline && end > begin && input[end - 1] == '\r')
+                    --end;
+                std::string_view text = input.substr(begin, end - begin);
+                f.escaped = 0;
+                if (!text.empty() && text.front() == d.quote) {
+                    if (text.size() < 2 || text.back() != d.quote)
+                        return false;
+                    ++begin;
+                    --end;
+                    text = text.substr(1, text.size() - 2);
+                    // inside, quotes come in pairs
+                    for (std::size_t i = 0; i < text.size(); ++i) {
+                        if (text[i] == d.quote) {
+                            if (i + 1 == text.size() || text[i + 1] != d.quote)
+                                return false;
+                            f.escaped = 1;
+                            ++i;
+                        }
+                    }
+                } else if (!text.empty() && std::memchr(text.data(), d.quote, text.size())) {
+                    return false;
+                }
+                f.offset = static_cast<std::uint32_t>(begin);
+                f.length = static_cast<std::uint32_t>(end - begin);
+                return true;
+            }
+
+            result validate(table const& out, error& err) const {
+                std::string unescaped;
+                for (std::size_t c = 0; c < grammars.size() && c < out.cols.size(); ++c) {
+                    if (!grammars[c])
+                        continue;
+                    for (std::size_t r = 0; r < out.cols[c].size(); ++r) {
+                        lm::csv::field const& f = out.cols[c][r];
+                        std::string_view text = out.raw(f);
+                        if (f.escaped) {
+                            out.value(f, unescaped);
+                            text = unescaped;
+                        }
+                        if (!grammars[c](text)) {
+                            err.row = r;
+                            err.column = c;
+                            return result::invalid_field;
+                        }
+                    }
+                }
+                return result::ok;
+            }
+
+            dialect d;
+            unsigned thread_count = 1;
+            std::vector<std::function<bool(std::string_view)>> grammars;
+        };
+    }
+}
@@ -0,0 +1,157 @@
+/// @file limn_generator.h
+/// @author Joseph Malle
+/// @brief Pull matches out of Limn one at a time with C++20 coroutines
+/// @details `lm::find_all` and `operator[](std::function)` push each match
+///     into a callback.  The generators here hand them out on demand
+///     instead, so a loop can stop early or feed the matches into another
+///     stage at its own pace:
+///
+///         for (std::string_view line : lm::records(input, +!lm::char_('\n') >> lm::char_('\n'), lm::nosk))
+///             if (handle(line) == stop)
+///                 break;
+///
+///     The parser only runs when the next match is pulled.  The coroutine
+///     frame is allocated once per generator and nothing is allocated per
+///     match.  Without coroutine support this header declares nothing and
+///     the rest of Limn is unchanged.
+
+#pragma once
+
+#include "limn.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+#define LIMN_HAS_GENERATOR 1
+
+namespace lm {
+
+    /// @class generator
+    /// @brief A lazy, single pass range of values made by a coroutine
+    /// @details Move-only.  Destroying the generator, for example by
+    ///     breaking out of a range-for, destroys the suspended coroutine.
+    template <typename T>
+    class generator {
+    public:
+        struct promise_type {
+            generator get_return_object() noexcept {
+                return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(T value) noexcept {
+                current = std::move(value);
+                return {};
+            }
+            void return_void() noexcept {}
+            // the parsers are noexcept, so this is a bug in a callback
+            void unhandled_exception() noexcept { std::terminate(); }
+
+            T current{};
+        };
+
+        struct sentinel {};
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+
+            iterator() noexcept = default;
+            explicit iterator(std::coroutine_handle<promise_type> handle) noexcept
+                : handle(handle)
+            {}
+
+            T const& operator*() const noexcept { return handle.promise().current; }
+            iterator& operator++() noexcept {
+                handle.resume();
+                return *this;
+            }
+            void operator++(int) noexcept { ++*this; }
+            bool operator==(sentinel) const noexcept { return !handle || handle.done(); }
+
+        private:
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        generator(generator&& other) noexcept
+            : handle(std::exchange(other.handle, nullptr))
+        {}
+
+        generator& operator=(generator&& other) noexcept {
+            if (this != &other) {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~generator() {
+            if (handle)
+                handle.destroy();
+        }
+
+        /// @brief Runs the coroutine to its first value
+        iterator begin() noexcept {
+            if (handle)
+                handle.resume();
+            return iterator(handle);
+        }
+
+        sentinel end() const noexcept { return {}; }
+
+    private:
+        explicit generator(std::coroutine_handle<promise_type> handle) noexcept
+            : handle(handle)
+        {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    /// @brief Lazily find every match of a parser in \p input
+    /// @details The pull version of `lm::find_all`: yields each match, from
+    ///     left to right and without overlaps, as `lm::searcher_` finds it.
+    ///     \p parser is copied into the coroutine, so temporaries are fine.
+    ///
+    /// @param[in] input The text to search.  Must outlive the generator.
+    /// @param[in] parser The parser to look for
+    /// @param[in] skipper Skips whitespace inside the grammar
+    template <typename Parser>
+    generator<std::string_view> matches(std::string_view input, Parser parser, Skipper& skipper = skws) {
+        searcher_<Parser> const finder(std::move(parser));
+        std::string_view match;
+        while (finder.next(input, match, skipper))
+            co_yield match;
+    }
+
+    /// @brief Lazily parse \p input as a sequence of records
+    /// @details Yields the text of each consecutive match of \p record from
+    ///     the front of \p input, skipping between records, like pulling
+    ///     the iterations of `*record` one at a time.  \p input is advanced
+    ///     past each record as it is pulled.  When the loop ends, an empty
+    ///     \p input means every record parsed; otherwise it starts at the
+    ///     text that didn't.
+    ///
+    /// @param[inout] input The text to parse.  Must outlive the generator.
+    /// @param[in] record The parser for one record
+    /// @param[in] skipper Skips whitespace between and inside records
+    template <typename Parser>
+    generator<std::string_view> records(std::string_view& input, Parser record, Skipper& skipper = skws) {
+        for (impl::skip(input, skipper); !input.empty(); impl::skip(input, skipper)) {
+            std::string_view const save = input;
+            if (!impl::visit_skipped(record, input, skipper) || input.size() == save.size()) {
+                input = save;
+                co_return;
+            }
+            co_yield impl::matched(save, input);
+        }
+    }
+}
+
+#endif
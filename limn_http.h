@@ -0,0 +1,315 @@
+/// @file limn_http.h
+/// @author Joseph Malle
+/// @brief Zero-copy HTTP/1.1 message head parser built on Limn
+/// @details Parses request and response heads (the start line and the
+///     header fields, up to the empty line) into `std::string_view`s that
+///     point into the input.  Headers go into an array that the caller
+///     owns, so nothing is allocated:
+///
+///         lm::http::header headers[32];
+///         lm::http::request req;
+///         switch (lm::http::parse_request(buffer, req, headers)) {
+///         case lm::http::result::complete:   // the body starts at buffer.substr(req.length)
+///         case lm::http::result::incomplete: // read more and call again with the longer buffer
+///         default:                           // reply 400
+///         }
+///
+///     Lines end with "\r\n" or a bare "\n".  A buffer that stops anywhere
+///     inside the head, even between the "\r" and the "\n", is incomplete,
+///     not invalid.  `lm::http::parse_chunk` decodes "Transfer-Encoding:
+///     chunked" bodies the same way.
+
+#pragma once
+
+#include "limn.h"
+
+namespace lm {
+    namespace http {
+
+        /// @struct header
+        /// @brief One header field.  The value has no surrounding whitespace
+        struct header {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        /// @brief The outcome of a parse
+        enum class result {
+            complete,         ///< parsed, the lengths and views are set
+            incomplete,       ///< valid so far, call again with more input
+            invalid,          ///< malformed
+            too_many_headers  ///< more header fields than the array holds
+        };
+
+        namespace impl {
+            // Character classes as one table lookup each
+            constexpr unsigned char TCHAR = 1;
+            constexpr unsigned char VCHAR = 2;
+            constexpr unsigned char FIELD = 4;
+
+            struct char_table {
+                constexpr char_table() noexcept
+                    : bits()
+                {
+                    for (unsigned ch = 0; ch < 256; ++ch) {
+                        // visible characters, and obs-text (bytes >= 0x80)
+                        if (ch > 0x20 && ch != 0x7f)
+                            bits[ch] |= static_cast<unsigned char>(VCHAR + FIELD);
+                        // the characters of RFC 7230 tokens (method, header names)
+                        if (('0' <= ch && ch <= '9') || lm::impl::is_ascii_alpha(static_cast<char>(ch)))
+                            bits[ch] |= TCHAR;
+                    }
+                    for (char const* s = "!#$%&'*+-.^_`|~"; *s; ++s)
+                        bits[static_cast<unsigned char>(*s)] |= TCHAR;
+                    // space and tab are allowed inside a header value
+                    bits[static_cast<unsigned char>(' ')] |= FIELD;
+                    bits[static_cast<unsigned char>('\t')] |= FIELD;
+                }
+
+                unsigned char bits[256];
+            };
+
+            constexpr inline char_table chars;
+
+            constexpr bool is_digit(char ch) noexcept {
+                return '0' <= ch && ch <= '9';
+            }
+
+            constexpr bool is_hex(char ch) noexcept {
+                return is_digit(ch) || ('a' <= ch && ch <= 'f') || ('A' <= ch && ch <= 'F');
+            }
+
+            // Min or more characters of a class, in one loop over the table.
+            // The same as +char_if_ or *char_if_ without a call per character
+            template <unsigned char Class, std::size_t Min>
+            struct run_ final : public lm::impl::parser_base<run_<Class, Min>> {
+                constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                    std::size_t n = 0;
+                    while (n < sv.size() && (chars.bits[static_cast<unsigned char>(sv[n])] & Class))
+                        ++n;
+                    if (n < Min)
+                        return false;
+                    sv.remove_prefix(n);
+                    return true;
+                }
+
+                inline bool first(lm::impl::byteset& set) const noexcept {
+                    for (unsigned ch = 0; ch < 256; ++ch)
+                        if (chars.bits[ch] & Class)
+                            set.insert(static_cast<unsigned char>(ch));
+                    return Min == 0;
+                }
+            };
+
+            [[maybe_unused]] constexpr static inline auto token = run_<TCHAR, 1>();
+            [[maybe_unused]] constexpr static inline auto target = run_<VCHAR, 1>();
+            [[maybe_unused]] constexpr static inline auto field = run_<FIELD, 0>();
+            [[maybe_unused]] constexpr static inline auto ows = *charset_(" \t");
+            [[maybe_unused]] constexpr static inline auto digit = range_('0', '9');
+
+            // The next line of input without its "\r\n" or "\n".  False if
+            // the line isn't finished yet.
+            inline bool next_line(std::string_view& input, std::string_view& line) noexcept {
+                void const* nl = input.empty() ? nullptr : std::memchr(input.data(), '\n', input.size());
+                if (!nl)
+                    return false;
+                std::size_t const end = static_cast<std::size_t>(static_cast<char const*>(nl) - input.data());
+                line = input.substr(0, end > 0 && input[end - 1] == '\r' ? end - 1 : end);
+                input.remove_prefix(end + 1);
+                return true;
+            }
+
+            inline std::string_view trim_ows(std::string_view sv) noexcept {
+                while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t'))
+                    sv.remove_suffix(1);
+                return sv;
+            }
+
+            // header lines up to and including the empty line
+            inline result parse_headers(std::string_view& input, header* headers, std::size_t capacity, std::size_t& count) noexcept {
+                count = 0;
+                std::string_view line;
+                while (next_line(input, line)) {
+                    if (line.empty())
+                        return result::complete;
+                    if (count == capacity)
+                        return result::too_many_headers;
+                    header& h = headers[count];
+                    // no space before the colon, and no obs-fold continuation lines
+                    if (!parse(line, token[h.name] >> char_(':') >> ows >> field[h.value] >> end_, nosk))
+                        return result::invalid;
+                    h.value = trim_ows(h.value);
+                    ++count;
+                }
+                return result::incomplete;
+            }
+
+            inline bool iequals(std::string_view a, std::string_view b) noexcept {
+                if (a.size() != b.size())
+                    return false;
+                for (std::size_t i = 0; i < a.size(); ++i)
+                    if (lm::impl::ascii_lower(a[i]) != lm::impl::ascii_lower(b[i]))
+                        return false;
+                return true;
+            }
+        }
+
+        /// @struct message
+        /// @brief What request and response heads have in common
+        struct message {
+            int minor_version = 0;         ///< 0 for HTTP/1.0, 1 for HTTP/1.1
+            header const* headers = nullptr; ///< the caller's array
+            std::size_t header_count = 0;
+            std::size_t length = 0;        ///< bytes in the head, the body starts here
+
+            /// @brief Case-insensitive header lookup
+            /// @returns the first header called \p name, or nullptr
+            header const* find(std::string_view name) const noexcept {
+                for (std::size_t i = 0; i < header_count; ++i)
+                    if (impl::iequals(headers[i].name, name))
+                        return headers + i;
+                return nullptr;
+            }
+        };
+
+        /// @struct request
+        struct request : message {
+            std::string_view method;
+            std::string_view target;
+        };
+
+        /// @struct response
+        struct response : message {
+            int status = 0;
+            std::string_view reason;
+        };
+
+        /// @brief Parse an HTTP/1.x request head
+        /// @param[in] input The bytes received so far
+        /// @param[out] req Set on `result::complete`
+        /// @param[out] headers Receives the header fields
+        /// @param[in] capacity The size of \p headers
+        /// @returns whether the head is complete, needs more input or is bad
+        inline result parse_request(std::string_view input, request& req, header* headers, std::size_t capacity) noexcept {
+            std::string_view const start = input;
+            std::string_view line;
+            // a robust server ignores empty lines before the request line
+            do {
+                if (!impl::next_line(input, line))
+                    return result::incomplete;
+            } while (line.empty());
+
+            std::string_view minor;
+            auto const request_line = impl::token[req.method] >> char_(' ')
+                >> impl::target[req.target] >> char_(' ')
+                >> lit_("HTTP/1.") >> impl::digit[minor] >> end_;
+            if (!parse(line, request_line, nosk))
+                return result::invalid;
+
+            result const r = impl::parse_headers(input, headers, capacity, req.header_count);
+            if (r != result::complete)
+                return r;
+            req.minor_version = minor[0] - '0';
+            req.headers = headers;
+            req.length = start.size() - input.size();
+            return result::complete;
+        }
+
+        /// @brief Parse an HTTP/1.x request head into an array
+        template <std::size_t N>
+        inline result parse_request(std::string_view input, request& req, header (&headers)[N]) noexcept {
+            return parse_request(input, req, headers, N);
+        }
+
+        /// @brief Parse an HTTP/1.x response head
+        /// @param[in] input The bytes received so far
+        /// @param[out] res Set on `result::complete`
+        /// @param[out] headers Receives the header fields
+        /// @param[in] capacity The size of \p headers
+        /// @returns whether the head is complete, needs more input or is bad
+        inline result parse_response(std::string_view input, response& res, header* headers, std::size_t capacity) noexcept {
+            std::string_view const start = input;
+            std::string_view line;
+            if (!impl::next_line(input, line))
+                return result::incomplete;
+
+            std::string_view minor;
+            std::string_view status;
+            // the reason phrase may be empty, and some servers drop its space
+            auto const status_line = lit_("HTTP/1.") >> impl::digit[minor] >> char_(' ')
+                >> repeat_<3>(impl::digit)[status]
+                >> opt_(char_(' ') >> impl::field[res.reason]) >> end_;
+            res.reason = {};
+            if (!parse(line, status_line, nosk))
+                return result::invalid;
+
+            result const r = impl::parse_headers(input, headers, capacity, res.header_count);
+            if (r != result::complete)
+                return r;
+            res.minor_version = minor[0] - '0';
+            res.status = (status[0] - '0') * 100 + (status[1] - '0') * 10 + (status[2] - '0');
+            res.headers = headers;
+            res.length = start.size() - input.size();
+            return result::complete;
+        }
+
+        /// @brief Parse an HTTP/1.x response head into an array
+        template <std::size_t N>
+        inline result parse_response(std::string_view input, response& res, header (&headers)[N]) noexcept {
+            return parse_response(input, res, headers, N);
+        }
+
+        /// @brief Decode one chunk of a "Transfer-Encoding: chunked" body
+        /// @details On `result::complete`, \p data is the chunk's payload and
+        ///     \p body is advanced past the chunk.  The last chunk has an
+        ///     empty payload; its trailer fields are skipped.  On
+        ///     `result::incomplete` \p body is unchanged.  For example:
+        ///
+        ///         std::string_view data;
+        ///         while (parse_chunk(body, data) == result::complete && !data.empty())
+        ///             append(data);
+        ///
+        /// @param[inout] body The body bytes received so far
+        /// @param[out] data The payload of the chunk
+        inline result parse_chunk(std::string_view& body, std::string_view& data) noexcept {
+            std::string_view input = body;
+            std::string_view line;
+            if (!impl::next_line(input, line))
+                return result::incomplete;
+
+            std::string_view hex;
+            // chunk extensions after ';' are allowed and ignored
+            if (!parse(line, (+char_if_(impl::is_hex))[hex] >> impl::ows >> opt_(char_(';') >> impl::field) >> end_, nosk))
+                return result::invalid;
+            while (hex.size() > 1 && hex.front() == '0')
+                hex.remove_prefix(1);
+            if (hex.size() > 2 * sizeof(std::size_t) - 1)
+                return result::invalid;
+            std::size_t size = 0;
+            for (char ch : hex)
+                size = size * 16 + static_cast<std::size_t>(impl::is_digit(ch) ? ch - '0' : lm::impl::ascii_lower(ch) - 'a' + 10);
+
+            if (size == 0) {
+                // trailer fields, then the empty line
+                do {
+                    if (!impl::next_line(input, line))
+                        return result::incomplete;
+                } while (!line.empty());
+                data = input.substr(0, 0);
+                body = input;
+                return result::complete;
+            }
+            if (input.size() < size)
+                return result::incomplete;
+            std::string_view const payload = input.substr(0, size);
+            input.remove_prefix(size);
+            if (input.empty() || input == "\r")
+                return result::incomplete;
+            if (!parse_ref(input, lit_("\r\n") | char_('\n'), nosk))
+                return result::invalid;
+            data = payload;
+            body = input;
+            return result::complete;
+        }
+    }
+}
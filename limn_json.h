@@ -0,0 +1,395 @@
+/// @file limn_json.h
+/// @author Joseph Malle
+/// @brief JSON validator and parser built on Limn
+/// @details Parses RFC 8259 JSON into a tape: a flat array of values in
+///     document order that point into the input, with no objects
+///     allocated per value.  The tape goes into an array that the caller
+///     owns, like `lm::capture_buffer`:
+///
+///         lm::json::value values[256];
+///         lm::json::tape tape(values);
+///         if (lm::json::parse(input, tape) == lm::json::result::ok) {
+///             for (lm::json::value const& v : tape)
+///                 if (v.kind == lm::json::type::key && tape.text(v) == "id")
+///                     ...
+///         }
+///
+///     Arrays and objects are a begin and an end entry that know each
+///     other's index, so a reader can skip a whole subtree in one step.
+///     Strings and numbers are left as text; `lm::json::unescape`,
+///     `lm::json::to_double` and `lm::json::to_int64` convert them when
+///     they are needed.  `lm::json::valid` checks a document without a
+///     tape.
+///
+///     The grammar is ordinary Limn combinators with `lm::action_` for the
+///     recursion.  Only the body of a string is hand written, to scan 8
+///     bytes at a time for the quote, the backslash and control bytes.
+
+#pragma once
+
+#include "limn.h"
+
+#include <charconv>
+#include <string>
+
+namespace lm {
+    namespace json {
+
+        /// @brief What a tape entry is
+        enum class type : std::uint8_t {
+            null,
+            boolean,       ///< the text is "true" or "false"
+            number,
+            string,        ///< the text is between the quotes, still escaped
+            key,           ///< a string before a ':'
+            begin_array,
+            end_array,
+            begin_object,
+            end_object
+        };
+
+        /// @struct value
+        /// @brief One entry of the tape
+        struct value {
+            type kind;
+            std::uint32_t offset;  ///< where the text starts in the input
+            std::uint32_t length;
+            std::uint32_t match;   ///< for begin and end entries, the index of the other one
+        };
+
+        /// @brief The outcome of a parse
+        enum class result {
+            ok,
+            invalid,    ///< not JSON
+            too_deep,   ///< nested deeper than the limit
+            tape_full   ///< valid, but the tape was too small, see `tape::needed`
+        };
+
+        class tape;
+
+        namespace impl {
+            struct document;
+        }
+
+        /// @class tape
+        /// @brief The values of a document, in a buffer that the caller owns
+        class tape {
+        public:
+            /// @param[in] data Where to store the values
+            /// @param[in] capacity How many values fit in \p data
+            constexpr tape(value* data, std::size_t capacity) noexcept
+                : data(data)
+                , capacity(capacity)
+            {}
+
+            template <std::size_t N>
+            constexpr explicit tape(value (&data)[N]) noexcept
+                : tape(data, N)
+            {}
+
+            /// @brief How many values are stored
+            constexpr std::size_t size() const noexcept { return count < capacity ? count : capacity; }
+            constexpr bool empty() const noexcept { return count == 0; }
+
+            /// @brief How many values the last document had, stored or not
+            constexpr std::size_t needed() const noexcept { return count; }
+
+            constexpr value const* begin() const noexcept { return data; }
+            constexpr value const* end() const noexcept { return data + size(); }
+            constexpr value const& operator[](std::size_t i) const noexcept { return data[i]; }
+
+            /// @brief The input text of \p v
+            constexpr std::string_view text(value const& v) const noexcept {
+                return source.substr(v.offset, v.length);
+            }
+
+            /// @brief The index after the value at \p i and everything in it
+            constexpr std::size_t next(std::size_t i) const noexcept {
+                return (data[i].kind == type::begin_array || data[i].kind == type::begin_object) ? data[i].match + 1 : i + 1;
+            }
+
+            /// @brief The input of the last parse
+            std::string_view source;
+
+        private:
+            friend struct impl::document;
+
+            value* data;
+            std::size_t capacity;
+            std::size_t count = 0;
+        };
+
+        namespace impl {
+            constexpr std::uint64_t ones = 0x0101010101010101u;
+            constexpr std::uint64_t high = 0x8080808080808080u;
+
+            // the high bit of each byte of x that is below n, for n <= 0x80.
+            // Only the lowest set bit is exact, the ones above it can be wrong
+            constexpr std::uint64_t less_than(std::uint64_t x, unsigned char n) noexcept {
+                return (x - ones * n) & ~x & high;
+            }
+
+            constexpr std::uint64_t equal_to(std::uint64_t x, unsigned char ch) noexcept {
+                return less_than(x ^ (ones * ch), 1);
+            }
+
+            // The characters of a string up to its closing quote.  Plain
+            // characters are skipped 8 at a time; a word stops at the first
+            // quote, backslash or control byte in it
+            struct string_body final : public lm::impl::parser_base<string_body> {
+                constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                    std::size_t i = 0;
+                    for (;;) {
+                        while (i + 8 <= sv.size()) {
+                            std::uint64_t const x = lm::impl::load_u64(sv.data() + i);
+                            std::uint64_t const stop = equal_to(x, '"') | equal_to(x, '\\') | less_than(x, 0x20);
+                            if (stop) {
+                                i += lm::impl::ctz64(stop) / 8;
+                                break;
+                            }
+                            i += 8;
+                        }
+                        while (i < sv.size() && sv[i] != '"' && sv[i] != '\\' && static_cast<unsigned char>(sv[i]) >= 0x20)
+                            ++i;
+                        if (i == sv.size() || sv[i] != '\\') {
+                            break;
+                        }
+                        std::string_view rest = sv.substr(i + 1);
+                        if (!escape.visit(rest, skipper)) {
+                            return false;
+                        }
+                        i = sv.size() - rest.size();
+                    }
+                    if (i == sv.size() || sv[i] != '"') {
+                        return false; // unterminated, or a control byte
+                    }
+                    sv.remove_prefix(i);
+                    return true;
+                }
+
+                inline bool first(lm::impl::byteset& set) const noexcept {
+                    set.insert_all();
+                    return true;
+                }
+
+            private:
+                static constexpr auto hex = optimize(lexeme_(range_('0', '9') | range_('a', 'f') | range_('A', 'F')));
+                static constexpr auto escape = charset_("\"\\/bfnrt") | (char_('u') >> repeat_<4>(hex));
+            };
+
+            [[maybe_unused]] constexpr static inline auto ws = *optimize(lexeme_(char_(' ') | char_('\n') | char_('\r') | char_('\t')));
+            [[maybe_unused]] constexpr static inline auto quoted = char_('"') >> string_body() >> char_('"');
+            [[maybe_unused]] constexpr static inline auto number = opt_(char_('-')) >> (char_('0') | (range_('1', '9') >> *digit_))
+                >> opt_(char_('.') >> +digit_) >> opt_(charset_("eE") >> opt_(charset_("+-")) >> +digit_);
+
+            // The parse of one document.  Each rule is an lm::action_ so the
+            // rules can refer to each other and write the tape.
+            struct document {
+                document(std::string_view source, tape* out, std::size_t max_depth) noexcept
+                    : source(source)
+                    , out(out)
+                    , max_depth(max_depth)
+                {
+                    if (out) {
+                        out->source = source;
+                        out->count = 0;
+                    }
+                }
+
+                result run() noexcept {
+                    std::string_view sv = source;
+                    auto const element = action_([this](std::string_view& in) { return value(in); });
+                    if (!parse_ref(sv, ws >> element >> ws >> end_, nosk)) {
+                        return too_deep ? result::too_deep : result::invalid;
+                    }
+                    return out && out->count > out->capacity ? result::tape_full : result::ok;
+                }
+
+                bool value(std::string_view& sv) noexcept {
+                    if (sv.empty()) {
+                        return false;
+                    }
+                    // the branches start with different bytes, so at most one is tried
+                    switch (sv.front()) {
+                    case '{': return object(sv);
+                    case '[': return array(sv);
+                    case '"': return scalar(sv, quoted, type::string);
+                    case 't':
+                    case 'f': return scalar(sv, lit_("true") | lit_("false"), type::boolean);
+                    case 'n': return scalar(sv, lit_("null"), type::null);
+                    default: return scalar(sv, number, type::number);
+                    }
+                }
+
+                template <typename Parser>
+                bool scalar(std::string_view& sv, Parser const& parser, type kind) noexcept {
+                    std::string_view text;
+                    if (!parse_ref(sv, parser[text], nosk)) {
+                        return false;
+                    }
+                    if (kind == type::string || kind == type::key) {
+                        text = text.substr(1, text.size() - 2);
+                    }
+                    emit(kind, text);
+                    return true;
+                }
+
+                bool array(std::string_view& sv) noexcept {
+                    auto const element = action_([this](std::string_view& in) { return value(in); });
+                    return nested(sv, type::begin_array, type::end_array,
+                        char_('[') >> ws >> (char_(']') | (element % (ws >> char_(',') >> ws) >> ws >> char_(']'))));
+                }
+
+                bool object(std::string_view& sv) noexcept {
+                    auto const key = action_([this](std::string_view& in) { return scalar(in, quoted, type::key); });
+                    auto const element = action_([this](std::string_view& in) { return value(in); });
+                    auto const member = key >> ws >> char_(':') >> ws >> element;
+                    return nested(sv, type::begin_object, type::end_object,
+                        char_('{') >> ws >> (char_('}') | (member % (ws >> char_(',') >> ws) >> ws >> char_('}'))));
+                }
+
+                template <typename Parser>
+                bool nested(std::string_view& sv, type begin, type end, Parser const& parser) noexcept {
+                    if (depth == max_depth) {
+                        too_deep = true;
+                        return false;
+                    }
+                    ++depth;
+                    std::size_t const open = emit(begin, sv.substr(0, 1));
+                    std::string_view const save = sv;
+                    bool const ok = parse_ref(sv, parser, nosk);
+                    --depth;
+                    if (!ok) {
+                        sv = save;
+                        return false;
+                    }
+                    std::size_t const close = emit(end, save.substr(save.size() - sv.size() - 1, 1));
+                    link(open, close);
+                    return true;
+                }
+
+                std::size_t emit(type kind, std::string_view text) noexcept {
+                    if (!out) {
+                        return 0;
+                    }
+                    std::size_t const index = out->count++;
+                    if (index < out->capacity) {
+                        out->data[index] = json::value{ kind, static_cast<std::uint32_t>(text.data() - source.data()), static_cast<std::uint32_t>(text.size()), 0 };
+                    }
+                    return index;
+                }
+
+                void link(std::size_t open, std::size_t close) noexcept {
+                    if (out && close < out->capacity) {
+                        out->data[open].match = static_cast<std::uint32_t>(close);
+                        out->data[close].match = static_cast<std::uint32_t>(open);
+                    }
+                }
+
+                std::string_view source;
+                tape* out;
+                std::size_t max_depth;
+                std::size_t depth = 0;
+                bool too_deep = false;
+            };
+
+            inline unsigned hex_value(char ch) noexcept {
+                return ch <= '9' ? static_cast<unsigned>(ch - '0') : static_cast<unsigned>(lm::impl::ascii_lower(ch) - 'a' + 10);
+            }
+
+            inline void append_utf8(std::string& out, char32_t cp) {
+                if (cp < 0x80) {
+                    out += static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    out += static_cast<char>(0xc0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3f));
+                } else if (cp < 0x10000) {
+                    out += static_cast<char>(0xe0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                    out += static_cast<char>(0x80 | (cp & 0x3f));
+                } else {
+                    out += static_cast<char>(0xf0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                    out += static_cast<char>(0x80 | (cp & 0x3f));
+                }
+            }
+        }
+
+        /// @brief Parse a JSON document into a tape
+        /// @param[in] input The document.  Must outlive \p out.
+        /// @param[out] out Receives the values
+        /// @param[in] max_depth How deep arrays and objects may nest
+        /// @returns `result::ok` if \p input is JSON and the tape held it
+        inline result parse(std::string_view input, tape& out, std::size_t max_depth = 1024) noexcept {
+            if (input.size() > 0xffffffffu)
+                return result::invalid;
+            return impl::document(input, &out, max_depth).run();
+        }
+
+        /// @brief Check that \p input is one JSON document
+        inline bool valid(std::string_view input, std::size_t max_depth = 1024) noexcept {
+            return impl::document(input, nullptr, max_depth).run() == result::ok;
+        }
+
+        /// @brief The value of a string entry, with the escapes decoded
+        /// @param[in] raw The text of a string or key entry
+        /// @param[out] out The string, in UTF-8
+        /// @returns false for a lone surrogate
+        inline bool unescape(std::string_view raw, std::string& out) {
+            out.clear();
+            out.reserve(raw.size());
+            for (std::size_t i = 0; i < raw.size(); ++i) {
+                if (raw[i] != '\\') {
+                    out += raw[i];
+                    continue;
+                }
+                char const ch = raw[++i];
+                switch (ch) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    auto const code = [&](std::size_t at) {
+                        return (impl::hex_value(raw[at]) << 12) | (impl::hex_value(raw[at + 1]) << 8)
+                             | (impl::hex_value(raw[at + 2]) << 4) | impl::hex_value(raw[at + 3]);
+                    };
+                    char32_t cp = code(i + 1);
+                    i += 4;
+                    if (cp >= 0xd800 && cp < 0xdc00) {
+                        // a high surrogate needs a low one after it
+                        if (i + 6 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u')
+                            return false;
+                        char32_t const low = code(i + 3);
+                        if (low < 0xdc00 || low >= 0xe000)
+                            return false;
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                        i += 6;
+                    } else if (cp >= 0xdc00 && cp < 0xe000) {
+                        return false;
+                    }
+                    impl::append_utf8(out, cp);
+                    break;
+                }
+                default: out += ch; // '"', '\\' and '/'
+                }
+            }
+            return true;
+        }
+
+        /// @brief The value of a number entry as a double
+        inline bool to_double(std::string_view text, double& out) noexcept {
+            auto const [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+            return ec == std::errc() && end == text.data() + text.size();
+        }
+
+        /// @brief The value of a number entry as an integer
+        /// @returns false if it has a fraction or exponent, or doesn't fit
+        inline bool to_int64(std::string_view text, std::int64_t& out) noexcept {
+            auto const [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+            return ec == std::errc() && end == text.data() + text.size();
+        }
+    }
+}
@@ -0,0 +1,200 @@
+/// @file limn_trace.h
+/// @author Joseph Malle
+/// @brief Tracers for `lm::parse_traced`, to find out where a grammar spends its time
+/// @details Two tracers ship here.  `flame_graph` counts the visits of each
+///     stack of parsers and writes them as folded stacks, the input format
+///     of flamegraph.pl and speedscope:
+///
+///         lm::trace::flame_graph flame;
+///         lm::parse_traced(input, grammar, flame);
+///         flame.write(stdout); // seq_;alt_;lit_ 42
+///
+///     `event_log` keeps every event in a compact binary log to be looked
+///     at later, for example to find which offsets a rule is retried at.
+///     Read it back with `lm::trace::replay`.
+///
+///     Both allocate as they go, so they are for debugging, not for
+///     production parses.  Parses with `lm::parse` are not traced at all.
+
+#pragma once
+
+#include "limn.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lm {
+    namespace trace {
+
+        /// @class flame_graph
+        /// @brief Counts visits by the stack of parsers they happened in
+        /// @details Each visit is one sample of its stack, so a frame's width
+        ///     is the number of visits under it.  Backtracking shows up as
+        ///     wide frames under `alt_` and the repetitions.
+        class flame_graph {
+        public:
+            void enter(rule_info const& rule, std::size_t) {
+                depths.push_back(path.size());
+                if (!path.empty()) {
+                    path += ';';
+                }
+                path += rule.name;
+                ++samples[path];
+            }
+
+            void exit(rule_info const&, std::size_t, std::size_t) {
+                pop();
+            }
+
+            void fail(rule_info const&, std::size_t) {
+                pop();
+            }
+
+            /// @brief The folded stacks, one "a;b;c count" line per stack
+            std::string folded() const {
+                std::string out;
+                for (auto const& [stack, count] : samples) {
+                    out += stack;
+                    out += ' ';
+                    out += std::to_string(count);
+                    out += '\n';
+                }
+                return out;
+            }
+
+            /// @brief Write folded() to \p file
+            bool write(std::FILE* file) const {
+                const std::string out = folded();
+                return std::fwrite(out.data(), 1, out.size(), file) == out.size();
+            }
+
+            /// @brief The number of visits made with exactly this stack
+            unsigned long long count(std::string const& stack) const {
+                auto const it = samples.find(stack);
+                return it == samples.end() ? 0 : it->second;
+            }
+
+            void clear() {
+                samples.clear();
+                path.clear();
+                depths.clear();
+            }
+
+        private:
+            void pop() {
+                path.resize(depths.back());
+                depths.pop_back();
+            }
+
+            std::map<std::string, unsigned long long> samples;
+            std::string path;
+            std::vector<std::size_t> depths;
+        };
+
+        /// @brief The kinds of records in an event_log
+        enum class kind : std::uint8_t {
+            enter,
+            exit,
+            fail,
+            name, ///< names the rule the first time it is seen
+        };
+
+        /// @struct event
+        /// @brief One record of an event_log, in host byte order
+        /// @details For enter and fail, \p end is \p begin.  A name record is
+        ///     followed by \p begin bytes of the rule's name.
+        struct event {
+            kind what;
+            std::uint8_t reserved[3];
+            std::uint32_t rule;  ///< rules are numbered from 0 as they are seen
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        static_assert(sizeof(event) == 16, "event_log records are 16 bytes");
+
+        /// @class event_log
+        /// @brief Records every event as a 16 byte record
+        /// @details The log is the bytes of `event`s, with a name record before
+        ///     a rule's first event.  Offsets are 32 bits, so inputs should be
+        ///     under 4GB.
+        class event_log {
+        public:
+            void enter(rule_info const& rule, std::size_t offset) {
+                put(kind::enter, index(rule), offset, offset);
+            }
+
+            void exit(rule_info const& rule, std::size_t begin, std::size_t end) {
+                put(kind::exit, index(rule), begin, end);
+            }
+
+            void fail(rule_info const& rule, std::size_t begin) {
+                put(kind::fail, index(rule), begin, begin);
+            }
+
+            /// @brief The log so far
+            std::string_view bytes() const noexcept {
+                return std::string_view(log.data(), log.size());
+            }
+
+            /// @brief Write bytes() to \p file, which should be opened in binary mode
+            bool write(std::FILE* file) const {
+                return std::fwrite(log.data(), 1, log.size(), file) == log.size();
+            }
+
+            void clear() {
+                log.clear();
+                rules.clear();
+            }
+
+        private:
+            std::uint32_t index(rule_info const& rule) {
+                auto const [it, added] = rules.emplace(std::make_pair(rule.id, rule.type), static_cast<std::uint32_t>(rules.size()));
+                if (added) {
+                    put(kind::name, it->second, rule.name.size(), 0);
+                    log.append(rule.name.data(), rule.name.size());
+                }
+                return it->second;
+            }
+
+            void put(kind what, std::uint32_t rule, std::size_t begin, std::size_t end) {
+                const event e{ what, {}, rule, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end) };
+                log.append(reinterpret_cast<char const*>(&e), sizeof(e));
+            }
+
+            std::string log;
+            std::map<std::pair<void const*, void const*>, std::uint32_t> rules;
+        };
+
+        /// @brief Read back the log of an event_log
+        /// @details Calls `visitor(event const& e, std::string_view name)` for
+        ///     every enter, exit and fail record, with the name of its rule.
+        /// @returns false if \p log is cut short or names a rule it never named
+        template <typename Visitor>
+        bool replay(std::string_view log, Visitor&& visitor) {
+            std::vector<std::string_view> names;
+            while (log.size() >= sizeof(event)) {
+                event e;
+                std::memcpy(&e, log.data(), sizeof(e));
+                log.remove_prefix(sizeof(e));
+                if (e.what == kind::name) {
+                    if (e.rule != names.size() || log.size() < e.begin) {
+                        return false;
+                    }
+                    names.push_back(log.substr(0, e.begin));
+                    log.remove_prefix(e.begin);
+                } else if (e.rule < names.size()) {
+                    visitor(static_cast<event const&>(e), names[e.rule]);
+                } else {
+                    return false;
+                }
+            }
+            return log.empty();
+        }
+    }
+}
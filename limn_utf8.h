@@ -0,0 +1,402 @@
+/// @file limn_utf8.h
+/// @author Joseph Malle
+/// @brief UTF-8 code point parsers for Limn
+/// @details The parsers in limn.h work on bytes, so `!lm::char_(' ')` can
+///     split a multi-byte code point.  The parsers here decode one whole
+///     code point at a time and never match malformed UTF-8.  For example,
+///     a Unicode identifier is
+///
+///         lm::lexeme_(lm::u8id_start_ >> *lm::u8id_continue_)
+///
+///     `lm::utf8_valid` checks a whole buffer up front, 16 bytes at a time
+///     with SSSE3 where the CPU has it, and `lm::parse_utf8` is `lm::parse`
+///     on input that passed that check.
+
+#pragma once
+
+#include "limn.h"
+#include "limn_utf8_tables.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LIMN_UTF8_SSSE3 1
+#include <immintrin.h>
+#endif
+
+namespace lm {
+
+    namespace impl {
+        // Decodes the code point at the front of sv into cp and returns its
+        // length in bytes, or 0 if sv is empty or doesn't start with a
+        // well-formed sequence (overlong forms, surrogates and values past
+        // U+10FFFF are malformed).
+        constexpr std::size_t u8decode(std::string_view sv, char32_t& cp) noexcept {
+            if (sv.empty())
+                return 0;
+            unsigned char const b0 = static_cast<unsigned char>(sv[0]);
+            if (b0 < 0x80) {
+                cp = b0;
+                return 1;
+            }
+            std::size_t n = 0;
+            char32_t min = 0;
+            if (b0 >= 0xc2 && b0 <= 0xdf) {
+                n = 2; min = 0x80; cp = b0 & 0x1f;
+            } else if (b0 >= 0xe0 && b0 <= 0xef) {
+                n = 3; min = 0x800; cp = b0 & 0x0f;
+            } else if (b0 >= 0xf0 && b0 <= 0xf4) {
+                n = 4; min = 0x10000; cp = b0 & 0x07;
+            } else {
+                return 0;
+            }
+            if (sv.size() < n)
+                return 0;
+            for (std::size_t i = 1; i < n; ++i) {
+                unsigned char const b = static_cast<unsigned char>(sv[i]);
+                if ((b & 0xc0) != 0x80)
+                    return 0;
+                cp = (cp << 6) | (b & 0x3f);
+            }
+            if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+                return 0;
+            return n;
+        }
+
+        // the first byte of the encoding of cp
+        constexpr unsigned char u8lead(char32_t cp) noexcept {
+            return static_cast<unsigned char>(
+                cp < 0x80 ? cp
+                : cp < 0x800 ? 0xc0 | (cp >> 6)
+                : cp < 0x10000 ? 0xe0 | (cp >> 12)
+                : 0xf0 | (cp >> 18));
+        }
+
+        // every byte that can start a code point in [lo, hi]
+        inline void u8first(impl::byteset& set, char32_t lo, char32_t hi) noexcept {
+            for (unsigned b = u8lead(lo); b <= u8lead(hi); ++b)
+                set.insert(static_cast<unsigned char>(b));
+        }
+
+        template <std::size_t N>
+        constexpr bool u8in(unicode::range const (&table)[N], char32_t cp) noexcept {
+            std::size_t lo = 0;
+            std::size_t hi = N;
+            while (lo < hi) {
+                std::size_t const mid = lo + (hi - lo) / 2;
+                if (table[mid].hi < cp)
+                    lo = mid + 1;
+                else if (cp < table[mid].lo)
+                    hi = mid;
+                else
+                    return true;
+            }
+            return false;
+        }
+
+        constexpr bool u8is_letter(char32_t cp) noexcept {
+            if (cp < 0x80)
+                return ('a' <= cp && cp <= 'z') || ('A' <= cp && cp <= 'Z');
+            return u8in(unicode::letter, cp);
+        }
+
+        constexpr bool u8is_id_start(char32_t cp) noexcept {
+            if (cp < 0x80)
+                return ('a' <= cp && cp <= 'z') || ('A' <= cp && cp <= 'Z');
+            return u8in(unicode::id_start, cp);
+        }
+
+        constexpr bool u8is_id_continue(char32_t cp) noexcept {
+            if (cp < 0x80)
+                return ('a' <= cp && cp <= 'z') || ('A' <= cp && cp <= 'Z') || ('0' <= cp && cp <= '9') || cp == '_';
+            return u8in(unicode::id_continue, cp);
+        }
+
+        // one code point in [lo, hi], or outside it with Negate
+        template <bool Negate>
+        struct u8range_ final : public impl::parser_base<u8range_<Negate>> {
+            constexpr u8range_(char32_t lo, char32_t hi) noexcept
+                : lo(lo)
+                , hi(hi)
+            {}
+
+            constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+                char32_t cp = 0;
+                std::size_t const n = u8decode(sv, cp);
+                if (n != 0 && ((lo <= cp && cp <= hi) != Negate)) {
+                    sv.remove_prefix(n);
+                    return true;
+                }
+                return false;
+            }
+
+            inline bool first(impl::byteset& set) const noexcept {
+                if (Negate) {
+                    u8first(set, 0, 0x10ffff);
+                } else {
+                    u8first(set, lo, hi);
+                }
+                return false;
+            }
+
+            constexpr inline auto operator!() const& noexcept {
+                return u8range_<!Negate>(lo, hi);
+            }
+
+        private:
+            char32_t lo;
+            char32_t hi;
+        };
+
+        // Validation after "Validating UTF-8 In Less Than One Instruction Per
+        // Byte" (Keiser and Lemire): three table lookups on the high and low
+        // nibbles of each byte and the one before it find every malformed
+        // two-byte pattern, and a saturating subtract checks that 3 and 4
+        // byte sequences have all their continuation bytes.
+        constexpr unsigned char TOO_SHORT = 1 << 0;
+        constexpr unsigned char TOO_LONG = 1 << 1;
+        constexpr unsigned char OVERLONG_3 = 1 << 2;
+        constexpr unsigned char TOO_LARGE = 1 << 3;
+        constexpr unsigned char SURROGATE = 1 << 4;
+        constexpr unsigned char OVERLONG_2 = 1 << 5;
+        constexpr unsigned char TOO_LARGE_1000 = 1 << 6;
+        constexpr unsigned char OVERLONG_4 = 1 << 6;
+        constexpr unsigned char TWO_CONTS = 1 << 7;
+        constexpr unsigned char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        inline bool utf8_valid_scalar(char const* p, std::size_t n) noexcept {
+            std::size_t i = 0;
+            while (i < n) {
+                // 8 ASCII bytes at a time
+                if (i + 8 <= n && (load_u64(p + i) & 0x8080808080808080u) == 0) {
+                    i += 8;
+                    continue;
+                }
+                char32_t cp = 0;
+                std::size_t const len = u8decode(std::string_view(p + i, n - i), cp);
+                if (len == 0)
+                    return false;
+                i += len;
+            }
+            return true;
+        }
+
+#ifdef LIMN_UTF8_SSSE3
+        __attribute__((target("ssse3")))
+        inline __m128i utf8_errors(__m128i input, __m128i prev_input) noexcept {
+            __m128i const low_nibble = _mm_set1_epi8(0x0f);
+            __m128i const prev1 = _mm_alignr_epi8(input, prev_input, 15);
+            __m128i const byte_1_high = _mm_shuffle_epi8(_mm_setr_epi8(
+                // 0_______ ________ <ASCII in byte 1>
+                TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                // 10______ ________ <continuation in byte 1>
+                char(TWO_CONTS), char(TWO_CONTS), char(TWO_CONTS), char(TWO_CONTS),
+                // 1100____, 1101____, 1110____, 1111____ <lead bytes>
+                TOO_SHORT | OVERLONG_2,
+                TOO_SHORT,
+                TOO_SHORT | OVERLONG_3 | SURROGATE,
+                TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+            ), _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+            __m128i const byte_1_low = _mm_shuffle_epi8(_mm_setr_epi8(
+                char(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+                char(CARRY | OVERLONG_2),
+                char(CARRY),
+                char(CARRY),
+                char(CARRY | TOO_LARGE),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000),
+                char(CARRY | TOO_LARGE | TOO_LARGE_1000)
+            ), _mm_and_si128(prev1, low_nibble));
+            __m128i const byte_2_high = _mm_shuffle_epi8(_mm_setr_epi8(
+                // ________ 0_______ <ASCII in byte 2>
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                // ________ 1000____, 1001____, 101_____
+                char(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+                char(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+                char(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+                char(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+                // ________ 11______
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+            ), _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+            __m128i const special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+            // the third and fourth bytes of 3 and 4 byte sequences must be
+            // continuations, which the lookups above flagged as TWO_CONTS
+            __m128i const prev2 = _mm_alignr_epi8(input, prev_input, 14);
+            __m128i const prev3 = _mm_alignr_epi8(input, prev_input, 13);
+            __m128i const third = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xe0 - 0x80)));
+            __m128i const fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xf0 - 0x80)));
+            __m128i const must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+            return _mm_xor_si128(must23, special);
+        }
+
+        struct utf8_state {
+            __m128i error;
+            __m128i prev_input;
+            __m128i prev_incomplete;
+        };
+
+        __attribute__((target("ssse3")))
+        inline void utf8_block(utf8_state& state, __m128i input) noexcept {
+            // nonzero where the last bytes of a block start a sequence that
+            // needs more bytes than are left in the block
+            __m128i const max_value = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                char(0xf0 - 1), char(0xe0 - 1), char(0xc0 - 1));
+            if (_mm_movemask_epi8(input) == 0) {
+                state.error = _mm_or_si128(state.error, state.prev_incomplete);
+                state.prev_incomplete = _mm_setzero_si128();
+            } else {
+                state.error = _mm_or_si128(state.error, utf8_errors(input, state.prev_input));
+                state.prev_incomplete = _mm_subs_epu8(input, max_value);
+            }
+            state.prev_input = input;
+        }
+
+        __attribute__((target("ssse3")))
+        inline bool utf8_valid_ssse3(char const* p, std::size_t n) noexcept {
+            utf8_state state = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+                utf8_block(state, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)));
+            if (i < n) {
+                // pad the tail with ASCII, which ends any open sequence
+                char tail[16] = {};
+                std::memcpy(tail, p + i, n - i);
+                utf8_block(state, _mm_loadu_si128(reinterpret_cast<__m128i const*>(tail)));
+            }
+            __m128i const error = _mm_or_si128(state.error, state.prev_incomplete);
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+        }
+#endif
+    }
+
+    /// @brief Check that \p input is well-formed UTF-8
+    /// @details Checks the whole input in one pass.  On x86 CPUs with SSSE3
+    ///     it looks at 16 bytes at a time with a few table lookups and no
+    ///     branches on the data, otherwise it skips ASCII 8 bytes at a time
+    ///     and decodes the rest.
+    /// @param[in] input The text to check
+    /// @returns true if \p input is well-formed
+    inline bool utf8_valid(std::string_view input) noexcept {
+#ifdef LIMN_UTF8_SSSE3
+#ifndef __SSSE3__
+        static bool const has_ssse3 = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+        if (has_ssse3)
+#endif
+            return impl::utf8_valid_ssse3(input.data(), input.size());
+#endif
+        return impl::utf8_valid_scalar(input.data(), input.size());
+    }
+
+    /// @brief The parse function for UTF-8 input
+    /// @details Like `lm::parse`, but fails on malformed UTF-8 before any
+    ///     parser runs, so no callback ever sees a broken code point.
+    /// @param[in] input The input string to parse
+    /// @param[in] parser The parser to evaluate on \p input
+    /// @returns true if \p input is well-formed and the parser matched it
+    template <typename Parser>
+    inline bool parse_utf8(std::string_view input, Parser const& parser, Skipper& skipper = skws) noexcept {
+        return utf8_valid(input) && parse(input, parser, skipper);
+    }
+
+    /// @brief Code point range parser
+    /// @details Matches one code point from \p lo to \p hi, inclusive.  For
+    ///     example, `lm::u8range_(U'α', U'ω')` parses "β", which is two bytes.
+    ///     `!lm::u8range_(lo, hi)` matches any code point outside the range.
+    /// @param[in] lo The first code point to accept
+    /// @param[in] hi The last code point to accept
+    constexpr inline auto u8range_(char32_t lo, char32_t hi) noexcept {
+        return impl::u8range_<false>(lo, hi);
+    }
+
+    /// @class u8char_
+    /// @brief Single code point parser
+    /// @details `lm::u8char_(U'é')` parses "é", and `lm::u8char_()` parses
+    ///     any one code point.  `!lm::u8char_(U' ')` matches any code point
+    ///     except a space, without splitting multi-byte sequences the way
+    ///     `!lm::char_(' ')` does.
+    struct u8char_ final : public impl::parser_base<u8char_> {
+        /// @brief Construct a u8char_ parser that accepts any code point
+        constexpr u8char_() noexcept
+            : range(0, 0x10ffff)
+        {}
+
+        /// @brief Construct a u8char_ parser
+        /// @param[in] cp The code point to accept
+        constexpr explicit u8char_(char32_t cp) noexcept
+            : range(cp, cp)
+        {}
+
+        /// @brief Opposite parser
+        /// @details Accepts every code point besides this one.
+        constexpr inline auto operator!() const& noexcept {
+            return !range;
+        }
+
+        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            return range.visit(sv, skipper);
+        }
+
+        inline bool first(impl::byteset& set) const noexcept {
+            return range.first(set);
+        }
+
+    private:
+        impl::u8range_<false> range;
+    };
+
+    /// @class u8if_
+    /// @brief Single code point parser based on a function
+    /// @details The code point analog of `lm::char_if_`.  For example,
+    ///     `lm::u8if_(isEmoji)` calls isEmoji with each decoded code point.
+    struct u8if_ final : public impl::parser_base<u8if_> {
+        /// @brief Construct a u8if_ parser
+        /// @param[in] pred The function that determines whether
+        ///     to parse a code point.
+        constexpr explicit u8if_(bool(*pred)(char32_t)) noexcept
+            : pred(pred)
+        {}
+
+        constexpr inline bool visit(std::string_view& sv, Skipper& skipper) const& noexcept {
+            char32_t cp = 0;
+            std::size_t const n = impl::u8decode(sv, cp);
+            if (n != 0 && pred(cp)) {
+                sv.remove_prefix(n);
+                return true;
+            }
+            return false;
+        }
+
+        // the ASCII that the predicate accepts, and any multi-byte lead
+        inline bool first(impl::byteset& set) const noexcept {
+            for (char32_t cp = 0; cp < 0x80; ++cp)
+                if (pred(cp))
+                    set.insert(static_cast<unsigned char>(cp));
+            impl::u8first(set, 0x80, 0x10ffff);
+            return false;
+        }
+
+    private:
+        bool(*pred)(char32_t);
+    };
+
+    /// @var u8letter_
+    /// @brief Single code point parser for letters (general category L)
+    [[maybe_unused]] constexpr static inline auto u8letter_ = u8if_(impl::u8is_letter);
+
+    /// @var u8id_start_
+    /// @brief Single code point parser for ID_Start (UAX #31), the
+    ///     code points that can begin an identifier
+    [[maybe_unused]] constexpr static inline auto u8id_start_ = u8if_(impl::u8is_id_start);
+
+    /// @var u8id_continue_
+    /// @brief Single code point parser for ID_Continue (UAX #31), the
+    ///     code points that can follow the first one in an identifier
+    [[maybe_unused]] constexpr static inline auto u8id_continue_ = u8if_(impl::u8is_id_continue);
+}
@@ -4,7 +4,7 @@
 #include <string_view>
 
 // This is only meant to show a Limn example.  It is not meant
-// to be a useful HTTP parser.
+// to be a useful HTTP parser.  For that, use limn_http.h.
 //
 // Also I can't imagine you're ever parsing HTTP at compile time!
 //
@@ -0,0 +1,260 @@
+/// @file pathological.h
+/// @brief Test harness that finds inputs where a grammar backtracks badly
+/// @details Wrap the rules of a grammar with `lm_test::rule` so their cost
+///     is counted, then call `lm_test::check_growth` with inputs of
+///     increasing size, either from a generator or found by fuzzing.  The
+///     harness fits how the cost of each rule grows with the input size
+///     and fails if any rule grows faster than n^max_exponent.
+///
+///     Cost is counted, not timed, so the results are the same on every
+///     machine: a visit costs one step plus every byte it moved over (less
+///     the bytes of the named rules inside it), which also catches a rule
+///     that is visited once per position but rescans the rest of the input
+///     each time.  Wall time is in the report too.
+
+#pragma once
+
+#include "limn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace lm_test {
+
+    /// @class profile
+    /// @brief The cost counters of a grammar's rules
+    class profile {
+    public:
+        /// @param[in] limit Total cost after which every rule fails, to
+        ///     cut exponential parses short
+        explicit profile(unsigned long long limit = 20000000) noexcept
+            : limit(limit)
+        {}
+
+        std::size_t add(std::string name) {
+            names.push_back(std::move(name));
+            costs.push_back(0);
+            return names.size() - 1;
+        }
+
+        // false once the limit is reached
+        bool charge(std::size_t rule, unsigned long long cost) noexcept {
+            costs[rule] += cost;
+            total += cost;
+            exhausted = exhausted || total > limit;
+            return !exhausted;
+        }
+
+        void reset() noexcept {
+            for (auto& cost : costs)
+                cost = 0;
+            total = 0;
+            nested = 0;
+            exhausted = false;
+        }
+
+        std::vector<std::string> names;
+        std::vector<unsigned long long> costs;
+        unsigned long long total = 0;
+        unsigned long long nested = 0; // bytes moved by the rules inside the current one
+        unsigned long long limit;
+        bool exhausted = false;
+    };
+
+    /// @class rule_
+    /// @brief A parser that charges its visits to a named rule
+    template <typename Parser>
+    struct rule_ final : public lm::impl::parser_base<rule_<Parser>> {
+        rule_(profile& prof, std::size_t index, Parser parser) noexcept
+            : prof(prof)
+            , index(index)
+            , parser(std::move(parser))
+        {}
+
+        template <typename Input>
+        bool visit(Input& sv, lm::Skipper& skipper) const& noexcept {
+            if (prof.exhausted)
+                return false;
+            const std::size_t before = sv.size();
+            const unsigned long long outer = prof.nested;
+            prof.nested = 0;
+            const bool matched = parser.visit(sv, skipper);
+            // a failed sequence can leave sv part way, that was work too.
+            // The bytes that nested rules moved over are theirs, not ours
+            const std::size_t moved = before > sv.size() ? before - sv.size() : 0;
+            const unsigned long long own = moved > prof.nested ? moved - prof.nested : 0;
+            prof.nested = outer + moved;
+            return prof.charge(index, 1 + own) && matched;
+        }
+
+        bool first(lm::impl::byteset& set) const noexcept {
+            return parser.first(set);
+        }
+
+    private:
+        profile& prof;
+        std::size_t index;
+        Parser parser;
+    };
+
+    /// @brief Name a rule of the grammar so its cost is counted
+    template <typename Parser>
+    rule_<Parser> rule(profile& prof, std::string name, Parser parser) {
+        const std::size_t index = prof.add(std::move(name));
+        return rule_<Parser>(prof, index, std::move(parser));
+    }
+
+    /// @struct growth_report
+    /// @brief What `check_growth` found
+    struct growth_report {
+        bool ok = true;
+        std::string rule;      ///< the rule that grew fastest
+        double exponent = 0;   ///< its cost grows as n^exponent
+        std::string input;     ///< the costliest input at the largest size
+        std::string message;   ///< a table of cost and time by size
+    };
+
+    /// @struct growth_options
+    struct growth_options {
+        std::vector<std::size_t> sizes = { 16, 32, 64, 128, 256 };
+        double max_exponent = 1.5;        ///< fail above n^max_exponent
+        std::string alphabet;             ///< fuzz with these characters...
+        std::vector<std::string> seeds;   ///< ...starting from these inputs, repeated to size
+        int mutations = 300;              ///< fuzzing steps per size
+        unsigned seed = 12345;
+    };
+
+    namespace impl {
+        template <typename Parser>
+        unsigned long long cost(profile& prof, Parser const& grammar, std::string const& input, lm::Skipper& skipper) {
+            prof.reset();
+            lm::parse(input, grammar, skipper);
+            return prof.exhausted ? prof.limit : prof.total;
+        }
+
+        // hill-climb from the seeds to the input of size n that costs the most
+        template <typename Parser>
+        std::string fuzz(profile& prof, Parser const& grammar, std::size_t n, growth_options const& options, lm::Skipper& skipper) {
+            std::mt19937 rng(options.seed + static_cast<unsigned>(n));
+            auto pick = [&](std::size_t count) { return std::uniform_int_distribution<std::size_t>(0, count - 1)(rng); };
+            std::vector<std::string> starts = options.seeds;
+            if (starts.empty())
+                starts.push_back(options.alphabet.substr(0, 1));
+
+            std::string best;
+            unsigned long long best_cost = 0;
+            for (std::string const& s : starts) {
+                std::string input;
+                while (input.size() < n)
+                    input += s.empty() ? std::string(1, 'a') : s;
+                input.resize(n);
+                const auto c = cost(prof, grammar, input, skipper);
+                if (best.empty() || c > best_cost) {
+                    best = input;
+                    best_cost = c;
+                }
+            }
+            for (int step = 0; step < options.mutations && n != 0 && best_cost < prof.limit; ++step) {
+                std::string next = best;
+                const std::size_t at = pick(n);
+                switch (pick(3)) {
+                case 0: // change a character
+                    if (!options.alphabet.empty())
+                        next[at] = options.alphabet[pick(options.alphabet.size())];
+                    break;
+                case 1: // insert one, keeping the size
+                    if (!options.alphabet.empty()) {
+                        next.insert(next.begin() + static_cast<std::ptrdiff_t>(at), options.alphabet[pick(options.alphabet.size())]);
+                        next.resize(n);
+                    }
+                    break;
+                default: { // copy a chunk somewhere else
+                    const std::size_t from = pick(n);
+                    const std::size_t len = 1 + pick(std::min<std::size_t>(8, n - std::max(at, from)));
+                    next.replace(at, len, best.substr(from, len));
+                    next.resize(n);
+                }
+                }
+                const auto c = cost(prof, grammar, next, skipper);
+                if (c >= best_cost) {
+                    best = std::move(next);
+                    best_cost = c;
+                }
+            }
+            return best;
+        }
+    }
+
+    /// @brief Check that the cost of a grammar grows slowly enough with its input
+    /// @param[in] prof The profile that the rules of \p grammar charge
+    /// @param[in] grammar The parser to check
+    /// @param[in] make_input Returns an input of about the given size, or
+    ///     nullptr to fuzz with the alphabet and seeds of \p options
+    /// @param[in] options Sizes, bound and fuzzing settings
+    /// @returns a report naming the rule that grew fastest
+    template <typename Parser, typename Generator>
+    growth_report check_growth(profile& prof, Parser const& grammar, Generator&& make_input, growth_options const& options = {}, lm::Skipper& skipper = lm::skws) {
+        growth_report report;
+        std::vector<std::vector<unsigned long long>> costs(prof.names.size());
+        std::vector<std::size_t> sizes;
+        char line[160];
+        report.message = "size        cost        time\n";
+
+        for (std::size_t n : options.sizes) {
+            std::string input;
+            if constexpr (std::is_same_v<std::decay_t<Generator>, std::nullptr_t>) {
+                input = impl::fuzz(prof, grammar, n, options, skipper);
+            } else {
+                input = make_input(n);
+            }
+            auto start = std::chrono::steady_clock::now();
+            impl::cost(prof, grammar, input, skipper);
+            auto stop = std::chrono::steady_clock::now();
+
+            sizes.push_back(input.size());
+            for (std::size_t r = 0; r < costs.size(); ++r)
+                costs[r].push_back(prof.costs[r]);
+            std::snprintf(line, sizeof(line), "%6zu %11llu %9.3fms%s\n", input.size(), prof.total,
+                std::chrono::duration<double, std::milli>(stop - start).count(), prof.exhausted ? "  (limit reached)" : "");
+            report.message += line;
+            report.input = input;
+
+            if (prof.exhausted) {
+                // whatever grows that fast, it is not polynomial in a useful way
+                std::size_t worst = 0;
+                for (std::size_t r = 0; r < costs.size(); ++r)
+                    if (prof.costs[r] > prof.costs[worst])
+                        worst = r;
+                report.ok = false;
+                report.rule = prof.names.empty() ? std::string() : prof.names[worst];
+                report.exponent = INFINITY;
+                report.message = "rule '" + report.rule + "' reached the cost limit\n" + report.message;
+                return report;
+            }
+        }
+
+        // slope of log(cost) against log(size) over the two largest sizes
+        for (std::size_t r = 0; r < costs.size() && sizes.size() >= 2; ++r) {
+            const std::size_t last = sizes.size() - 1;
+            const double c1 = static_cast<double>(costs[r][last - 1]);
+            const double c2 = static_cast<double>(costs[r][last]);
+            if (c1 == 0 || c2 == 0 || sizes[last] == sizes[last - 1])
+                continue;
+            const double exponent = std::log(c2 / c1) / std::log(double(sizes[last]) / double(sizes[last - 1]));
+            if (report.rule.empty() || exponent > report.exponent) {
+                report.rule = prof.names[r];
+                report.exponent = exponent;
+            }
+        }
+        report.ok = report.exponent <= options.max_exponent;
+        std::snprintf(line, sizeof(line), "rule '%s' grows as n^%.2f (bound n^%.2f)\n",
+            report.rule.c_str(), report.exponent, options.max_exponent);
+        report.message = line + report.message;
+        return report;
+    }
+}
@@ -0,0 +1,70 @@
+#include "limn.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test adaptive alternatives learn the order"){
+    branch_order<3> learned;
+    auto method = adapt_(lit_("TRACE") | lit_("POST") | lit_("GET"), learned);
+    CHECK(learned.adapts());
+    CHECK(learned.order()[0] == 0);
+
+    int matched = 0;
+    for (int i = 0; i < 3000; ++i)
+        matched += parse(i % 4 ? "GET" : "POST", *method >> end_);
+    CHECK(matched == 3000);
+    // copies of the rule, like the one in *method, count into learned too
+    CHECK(learned.order()[0] == 2);
+    CHECK(learned.order()[1] == 1);
+    CHECK(learned.order()[2] == 0);
+
+    // the results don't change
+    CHECK(parse("TRACE", method >> end_));
+    CHECK(parse("  POST", method >> end_));
+    CHECK(!parse("PUT", method));
+    CHECK(!parse("", method));
+}
+
+TEST_CASE("test adaptive alternatives keep overlapping branches in order"){
+    // "ab" and "a" both start with 'a', so the order matters
+    branch_order<3> learned;
+    auto prefix = adapt_(lit_("ab") | lit_("a") | char_('x'), learned);
+    CHECK(!learned.adapts());
+    for (int i = 0; i < 3000; ++i)
+        parse("x", prefix);
+    CHECK(learned.order()[0] == 0);
+
+    std::string_view matched;
+    CHECK(parse("abc", prefix[matched]));
+    CHECK(matched == "ab");
+
+    // an empty branch matches anywhere
+    branch_order<2> empty;
+    adapt_(char_('a') | opt_(char_('b')), empty);
+    CHECK(!empty.adapts());
+
+    // 'x' starts both branches, through the opt_ before the negated class
+    branch_order<2> negated;
+    auto not_x = adapt_((opt_(char_('x')) >> !char_('x')) | lit_("xx"), negated);
+    CHECK(!negated.adapts());
+    CHECK(parse("xx", not_x >> end_, nosk));
+}
+
+TEST_CASE("test reorder freezes an order"){
+    constexpr auto frozen = reorder_<2, 0, 1>(lit_("TRACE") | lit_("POST") | lit_("GET"));
+    CHECK(parse("GET", frozen >> end_));
+    CHECK(parse("TRACE", frozen >> end_));
+    CHECK(!parse("PUT", frozen));
+
+    // the branches really are tried in the new order
+    std::string_view matched;
+    CHECK(parse("ab", reorder_<1, 0>(lit_("a") | lit_("ab"))[matched]));
+    CHECK(matched == "ab");
+}
+
+}
@@ -0,0 +1,101 @@
+#include "limn.h"
+
+#include <functional>
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+enum : std::uint32_t { WORD, NUMBER, PAIR, KEY, VALUE, LIST };
+
+std::string dump(capture_buffer const& captures) {
+    std::string out;
+    for (capture const& c : captures)
+        out += std::to_string(c.tag) + ":" + std::string(captures.text(c)) + " ";
+    return out;
+}
+
+TEST_CASE("test capturing every repetition"){
+    capture storage[16];
+    capture_buffer captures(storage);
+
+    auto word = capture_(WORD, lexeme_(+alpha_));
+    CHECK(parse("the quick brown fox", *word >> end_, captures));
+    CHECK(captures.size() == 4);
+    CHECK(dump(captures) == "0:the 0:quick 0:brown 0:fox ");
+    CHECK(captures[2].begin == 10);
+    CHECK(captures[2].end == 15);
+
+    // outer captures come before the ones inside them
+    auto pair = capture_(PAIR, capture_(KEY, lexeme_(+alpha_)) >> char_('=') >> capture_(VALUE, lexeme_(+digit_)));
+    CHECK(parse("a=1, bb = 22", pair >> *(char_(',') >> pair) >> end_, captures));
+    CHECK(dump(captures) == "2:a=1 3:a 4:1 2:bb = 22 3:bb 4:22 ");
+
+    // without a buffer, capture_ is just its parser
+    CHECK(parse("a=1", pair >> end_));
+}
+
+TEST_CASE("test backtracked captures are dropped"){
+    capture storage[16];
+    capture_buffer captures(storage);
+
+    auto ident = lexeme_(+alpha_);
+    auto assign = capture_(KEY, ident) >> char_('=');
+    auto call = capture_(WORD, ident) >> char_('(') >> char_(')');
+    CHECK(parse("print()", assign | call, captures));
+    CHECK(dump(captures) == "0:print ");
+
+    // the last pass of a repetition fails after capturing "c", then the rest of the grammar takes it
+    auto list = *(capture_(LIST, ident) >> char_(',')) >> capture_(WORD, ident) >> end_;
+    CHECK(parse("a, b, c", list, captures));
+    CHECK(dump(captures) == "5:a 5:b 0:c ");
+
+    CHECK(parse("x", opt_(capture_(KEY, ident) >> char_('=')) >> capture_(VALUE, ident) >> end_, captures));
+    CHECK(dump(captures) == "4:x ");
+
+    // a failed parse leaves nothing behind
+    CHECK(!parse("a, b,", list, captures));
+    CHECK(captures.empty());
+}
+
+TEST_CASE("test capture buffer overflow"){
+    capture storage[2];
+    capture_buffer captures(storage);
+    auto words = *capture_(WORD, lexeme_(+alpha_)) >> end_;
+
+    CHECK(!parse("one two three", words, captures));
+    CHECK(captures.overflow());
+    CHECK(captures.needed() == 3);
+    CHECK(captures.size() == 2);
+    CHECK(dump(captures) == "0:one 0:two ");
+
+    CHECK(parse("one two", words, captures));
+    CHECK(!captures.overflow());
+}
+
+TEST_CASE("test captures in recursive rules"){
+    capture storage[32];
+    capture_buffer captures(storage);
+
+    // nested lists of numbers: (1 (2 3) 4)
+    std::function<bool(impl::capture_view&)> list_body;
+    auto list = action_([&](auto& sv) { return list_body(sv); });
+    auto item = capture_(NUMBER, lexeme_(+digit_)) | list;
+    list_body = [&](impl::capture_view& sv) {
+        return parse_ref(sv, capture_(LIST, char_('(') >> *item >> char_(')')));
+    };
+    CHECK(parse("(1 (2 3) 4)", list >> end_, captures));
+    CHECK(dump(captures) == "5:(1 (2 3) 4) 1:1 5:(2 3) 1:2 1:3 1:4 ");
+}
+
+TEST_CASE("test failed repetitions are rewound"){
+    // the second pass matches "a" then fails on the end, leaving " a" for the rest
+    CHECK(parse("ab a", *(char_('a') >> char_('b')) >> char_('a') >> end_));
+    CHECK(parse("ab a", +(char_('a') >> char_('b')) >> char_('a') >> end_));
+    CHECK(parse("a", opt_(char_('a') >> char_('b')) >> char_('a') >> end_));
+}
+
+}
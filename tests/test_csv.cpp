@@ -0,0 +1,96 @@
+#include "limn_csv.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test csv columns"){
+    csv::reader reader(csv::dialect{ ',', '"', true });
+    reader.field(0, lexeme_(+alpha_)).field(1, lexeme_(+digit_));
+    csv::table table;
+    const std::string input = "name,age,note\r\n"
+                              "ada,36,\"likes \"\"engines\"\"\"\r\n"
+                              "alan,41,\"a, b\nand c\"\n"
+                              "grace,85,";
+    REQUIRE(reader.read(input, table) == csv::result::ok);
+    CHECK(table.columns() == 3);
+    CHECK(table.rows() == 3);
+    CHECK(table.raw(table.names[2]) == "note");
+    CHECK(table.raw(table.column(0)[2]) == "grace");
+    CHECK(table.raw(table.column(2)[0]) == "likes \"\"engines\"\"");
+    CHECK(table.value(table.column(2)[0]) == "likes \"engines\"");
+    CHECK(table.value(table.column(2)[1]) == "a, b\nand c");
+    CHECK(table.raw(table.column(2)[2]).empty());
+
+    std::vector<std::int64_t> ages;
+    CHECK(table.to_int64(1, ages));
+    CHECK(ages == std::vector<std::int64_t>{ 36, 41, 85 });
+    std::vector<double> names;
+    CHECK(!table.to_double(0, names));
+}
+
+TEST_CASE("test csv errors"){
+    csv::reader reader;
+    csv::table table;
+    csv::error err;
+    CHECK(reader.read("a,b\nc\n", table, &err) == csv::result::ragged_row);
+    CHECK(err.row == 1);
+    CHECK(reader.read("a,b\nc,d,e\n", table, &err) == csv::result::ragged_row);
+    CHECK(reader.read("a,\"b\nc,d\n", table, &err) == csv::result::unterminated_quote);
+    CHECK(reader.read("a,b\"c\"d\n", table, &err) == csv::result::bad_quote);
+    CHECK(reader.read("a,\"b\"c\n", table, &err) == csv::result::bad_quote);
+
+    reader.field(1, lexeme_(+digit_));
+    CHECK(reader.read("a,1\nb,2\nc,x3\n", table, &err) == csv::result::invalid_field);
+    CHECK(err.row == 2);
+    CHECK(err.column == 1);
+
+    csv::reader tsv(csv::dialect{ '\t', '"', false });
+    CHECK(tsv.read("a\tb,c\n", table) == csv::result::ok);
+    CHECK(table.raw(table.column(1)[0]) == "b,c");
+    CHECK(tsv.read("", table) == csv::result::ok);
+    CHECK(table.rows() == 0);
+}
+
+TEST_CASE("test csv index across chunks"){
+    // long enough for several chunks, with quoted regions across their edges
+    std::string input;
+    for (int i = 0; i < 20000; ++i) {
+        input += std::to_string(i) + ",";
+        input += (i % 3) ? "plain" : "\"quoted, with\n\"\"newlines\"\" and, commas\"";
+        input += "," + std::string(i % 70, 'x') + "\n";
+    }
+    std::vector<std::uint32_t> one;
+    std::vector<std::uint32_t> many;
+    CHECK(csv::index(input, csv::dialect(), one, 1) == csv::result::ok);
+    CHECK(csv::index(input, csv::dialect(), many, 4) == csv::result::ok);
+    CHECK(one.size() == 3 * 20000);
+    CHECK(one == many);
+
+    // a byte loop as the reference
+    std::vector<std::uint32_t> expected;
+    bool inside = false;
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        if (input[i] == '"')
+            inside = !inside;
+        else if (!inside && (input[i] == ',' || input[i] == '\n'))
+            expected.push_back(static_cast<std::uint32_t>(i));
+    }
+    CHECK(one == expected);
+
+    csv::reader reader;
+    reader.field(0, lexeme_(+digit_)).threads(4);
+    csv::table table;
+    REQUIRE(reader.read(input, table) == csv::result::ok);
+    CHECK(table.rows() == 20000);
+    CHECK(table.value(table.column(1)[3]) == "quoted, with\n\"newlines\" and, commas");
+    std::vector<std::int64_t> ids;
+    CHECK(table.to_int64(0, ids));
+    CHECK(ids.back() == 19999);
+}
+
+}
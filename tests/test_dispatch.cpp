@@ -0,0 +1,61 @@
+#include "limn.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test dispatch to the matching grammar"){
+    auto const path = lexeme_(+!char_(' '));
+    dispatcher_ route(
+        lit_("GET ") >> path >> end_,
+        lit_("POST ") >> path >> end_,
+        lit_("PING") >> end_,
+        lit_("PUT ") >> path >> end_
+    );
+    CHECK(route.parse("GET /index.html") == 0);
+    CHECK(route.parse("POST /form") == 1);
+    CHECK(route.parse("PING") == 2);
+    CHECK(route.parse("PUT /file") == 3);
+    CHECK(route.parse("  PING") == 2);
+    CHECK(route.parse("PONG") == route.npos);
+    CHECK(route.parse("DELETE /file") == route.npos);
+    CHECK(route.parse("") == route.npos);
+}
+
+TEST_CASE("test dispatch matches like parse with ||"){
+    auto const number = lexeme_(+digit_) >> end_;
+    auto const word = lexeme_(+alpha_) >> end_;
+    auto const fallback = action_([](std::string_view& sv) { sv = sv.substr(sv.size()); return true; });
+    dispatcher_ route(number, word, fallback);
+    for (std::string_view input : { "123", "abc", "  42", "a1", "", "?" }) {
+        const std::size_t expected = parse(input, number) ? 0 : parse(input, word) ? 1 : parse(input, fallback) ? 2 : route.npos;
+        CHECK(route.parse(input) == expected);
+    }
+
+    // the first grammar that matches wins, even if a later one matches more
+    dispatcher_ first(char_('a'), lit_("ab"), opt_(char_('x')));
+    CHECK(first.parse("ab") == 0);
+    CHECK(first.parse("b") == 2);
+    CHECK(first.parse("") == 2);
+
+    // the FIRST set of !char_('x') must not wipe the 'x' of opt_(char_('x'))
+    auto const not_x = opt_(char_('x')) >> !char_('x');
+    dispatcher_ negated(lit_("zz"), not_x);
+    CHECK(parse("xy", not_x));
+    CHECK(negated.parse("xy") == 1);
+}
+
+TEST_CASE("test dispatch with a skipper"){
+    // char_ doesn't skip, so only the lexeme-free sequence sees past spaces
+    dispatcher_ route(char_('a'), char_('b') >> char_('c'));
+    CHECK(route.parse("a") == 0);
+    CHECK(route.parse(" a") == route.npos);
+    CHECK(route.parse(" b c") == 1);
+    CHECK(route.parse(" b c", nosk) == route.npos);
+}
+
+}
@@ -0,0 +1,67 @@
+#include "limn_generator.h"
+
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+// the generators need C++20, there is nothing to test in a C++17 build
+#ifdef LIMN_HAS_GENERATOR
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test pulling matches"){
+    std::vector<std::string_view> found;
+    for (std::string_view number : matches("a1 bb22 ccc333", lexeme_(+digit_)))
+        found.push_back(number);
+    CHECK(found == std::vector<std::string_view>{ "1", "22", "333" });
+
+    // stop early, the rest is never searched
+    int visits = 0;
+    auto counted = action_([&](std::string_view& sv) {
+        ++visits;
+        return parse_ref(sv, lexeme_(+digit_), nosk);
+    });
+    for (std::string_view number : matches("1 2 3 4 5 6", counted)) {
+        if (number == "2")
+            break;
+    }
+    CHECK(visits == 3); // "1", the space, "2"
+
+    auto none = matches("no digits", lexeme_(+digit_));
+    CHECK(none.begin() == none.end());
+}
+
+TEST_CASE("test pulling records"){
+    std::string_view input = "key1=value1\nkey2=value2\nkey3=value3\n";
+    auto record = lexeme_(+alnum_) >> char_('=') >> lexeme_(+alnum_);
+
+    auto lines = records(input, record);
+    auto it = lines.begin();
+    REQUIRE(it != lines.end());
+    CHECK(*it == "key1=value1");
+    // nothing past the first record has been parsed yet
+    CHECK(input.substr(0, 6) == "\nkey2=");
+    ++it;
+    REQUIRE(it != lines.end());
+    CHECK(*it == "key2=value2");
+    ++it;
+    CHECK(*it == "key3=value3");
+    ++it;
+    CHECK(it == lines.end());
+    CHECK(input.empty());
+
+    // a bad record ends the sequence and stays in the input
+    std::string_view broken = "a=1 b=2 c 3 d=4";
+    std::vector<std::string_view> pairs;
+    for (std::string_view pair : records(broken, record))
+        pairs.push_back(pair);
+    CHECK(pairs == std::vector<std::string_view>{ "a=1", "b=2" });
+    CHECK(broken == "c 3 d=4");
+}
+
+}
+
+#endif
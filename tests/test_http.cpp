@@ -0,0 +1,119 @@
+#include "limn_http.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm::http;
+
+const std::string_view browser_request =
+    "GET /wiki/HTTP?lang=en HTTP/1.1\r\n"
+    "Host: en.wikipedia.org\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=abc123; theme=dark\r\n"
+    "\r\n"
+    "body";
+
+TEST_CASE("test parsing a request head"){
+    header headers[16];
+    request req;
+    REQUIRE(parse_request(browser_request, req, headers) == result::complete);
+    CHECK(req.method == "GET");
+    CHECK(req.target == "/wiki/HTTP?lang=en");
+    CHECK(req.minor_version == 1);
+    CHECK(req.header_count == 7);
+    CHECK(browser_request.substr(req.length) == "body");
+    CHECK(headers[0].name == "Host");
+    CHECK(headers[0].value == "en.wikipedia.org");
+
+    // zero copy: the views point into the input
+    CHECK(req.target.data() == browser_request.data() + 4);
+
+    // header names are case-insensitive
+    REQUIRE(req.find("accept-ENCODING") != nullptr);
+    CHECK(req.find("accept-ENCODING")->value == "gzip, deflate, br");
+    CHECK(req.find("Content-Length") == nullptr);
+
+    // whitespace around values is dropped, bare LF ends lines, and leading empty lines are skipped
+    REQUIRE(parse_request("\r\nPOST /form HTTP/1.0\nContent-Length:  12 \t\nX-Empty:\n\n", req, headers) == result::complete);
+    CHECK(req.method == "POST");
+    CHECK(req.minor_version == 0);
+    CHECK(req.find("content-length")->value == "12");
+    CHECK(req.find("x-empty")->value.empty());
+}
+
+TEST_CASE("test partial and bad request heads"){
+    header headers[16];
+    request req;
+
+    // every proper prefix is incomplete, including a cut between \r and \n
+    const std::string_view head = browser_request.substr(0, browser_request.size() - 4);
+    int wrong = 0;
+    for (std::size_t n = 0; n < head.size(); ++n)
+        wrong += parse_request(head.substr(0, n), req, headers) != result::incomplete;
+    CHECK(wrong == 0);
+    CHECK(parse_request(head, req, headers) == result::complete);
+
+    header two[2];
+    CHECK(parse_request(head, req, two) == result::too_many_headers);
+
+    CHECK(parse_request("GET / HTTP/2.0\r\n\r\n", req, headers) == result::invalid);
+    CHECK(parse_request("GET  / HTTP/1.1\r\n\r\n", req, headers) == result::invalid);
+    CHECK(parse_request("G(T / HTTP/1.1\r\n\r\n", req, headers) == result::invalid);
+    CHECK(parse_request("GET / HTTP/1.1\r\nHost : a\r\n\r\n", req, headers) == result::invalid);
+    CHECK(parse_request("GET / HTTP/1.1\r\nHost: a\r\n folded\r\n\r\n", req, headers) == result::invalid);
+    CHECK(parse_request("GET / HTTP/1.1\r\nHost: a\x01" "b\r\n\r\n", req, headers) == result::invalid);
+}
+
+TEST_CASE("test parsing a response head"){
+    header headers[8];
+    response res;
+    REQUIRE(parse_response("HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 9\r\n\r\nnot found", res, headers) == result::complete);
+    CHECK(res.status == 404);
+    CHECK(res.reason == "Not Found");
+    CHECK(res.header_count == 2);
+    CHECK(res.find("CONTENT-TYPE")->value == "text/plain");
+    CHECK(res.length == 71);
+
+    CHECK(parse_response("HTTP/1.0 204\r\n\r\n", res, headers) == result::complete);
+    CHECK(res.status == 204);
+    CHECK(res.reason.empty());
+    CHECK(parse_response("HTTP/1.1 200 OK\r\nServer: x\r", res, headers) == result::incomplete);
+    CHECK(parse_response("HTTP/1.1 20 OK\r\n\r\n", res, headers) == result::invalid);
+}
+
+TEST_CASE("test decoding a chunked body"){
+    const std::string_view body = "4\r\nWiki\r\n6;ext=1\r\npedia \r\nE\r\nin \r\n\r\nchunks.\r\n0\r\nExpires: never\r\n\r\nnext";
+    std::string_view rest = body;
+    std::string_view data;
+    std::string decoded;
+    while (parse_chunk(rest, data) == result::complete && !data.empty())
+        decoded += data;
+    CHECK(decoded == "Wikipedia in \r\n\r\nchunks.");
+    CHECK(rest == "next");
+
+    // cut anywhere, the chunk is incomplete and nothing is consumed
+    const std::string_view first = "1a\r\nabcdefghijklmnopqrstuvwxyz\r\n";
+    int wrong = 0;
+    for (std::size_t n = 0; n < first.size(); ++n) {
+        std::string_view part = first.substr(0, n);
+        wrong += parse_chunk(part, data) != result::incomplete || part.size() != n;
+    }
+    CHECK(wrong == 0);
+    rest = first;
+    CHECK(parse_chunk(rest, data) == result::complete);
+    CHECK(data.size() == 26);
+
+    rest = "zz\r\n";
+    CHECK(parse_chunk(rest, data) == result::invalid);
+    rest = "2\r\nabX\r\n";
+    CHECK(parse_chunk(rest, data) == result::invalid);
+}
+
+}
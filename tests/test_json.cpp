@@ -0,0 +1,81 @@
+#include "limn_json.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test json tape"){
+    json::value values[32];
+    json::tape tape(values);
+    const std::string_view input = R"( {"name": "limn", "tags": ["peg", "c++17"], "stars": -1.5e3, "ok": true, "none": null} )";
+    REQUIRE(json::parse(input, tape) == json::result::ok);
+    CHECK(tape.size() == 15);
+    CHECK(tape[0].kind == json::type::begin_object);
+    CHECK(tape[0].match == 14);
+    CHECK(tape[14].kind == json::type::end_object);
+    CHECK(tape[1].kind == json::type::key);
+    CHECK(tape.text(tape[1]) == "name");
+    CHECK(tape.text(tape[2]) == "limn");
+    CHECK(tape[4].kind == json::type::begin_array);
+    CHECK(tape.next(4) == 8);
+    CHECK(tape.text(tape[6]) == "c++17");
+
+    double stars = 0;
+    CHECK(tape[9].kind == json::type::number);
+    CHECK(json::to_double(tape.text(tape[9]), stars));
+    CHECK(stars == -1500.0);
+    std::int64_t whole = 0;
+    CHECK(!json::to_int64(tape.text(tape[9]), whole));
+    CHECK(tape.text(tape[11]) == "true");
+    CHECK(tape[13].kind == json::type::null);
+
+    // too small a tape still validates and says how much it needs
+    json::value few[4];
+    json::tape small(few);
+    CHECK(json::parse(input, small) == json::result::tape_full);
+    CHECK(small.needed() == 15);
+    CHECK(small.size() == 4);
+}
+
+TEST_CASE("test json validation"){
+    for (const char* good : { "0", "-0.5", "1e10", "2E-3", "\"\"", "[]", "{}", "[[],{}]", " [1, 2 ,3 ] ",
+                              "\"\\u00e9\\n\\\"\"", "{\"a\":{\"b\":[null,false]}}", "\"caf\xc3\xa9\"" })
+        CHECK_MESSAGE(json::valid(good), good);
+    for (const char* bad : { "", "01", "1.", ".5", "+1", "-", "[1,]", "[1 2]", "{\"a\"}", "{a:1}", "{\"a\":1,}",
+                             "\"abc", "\"a\\x\"", "\"\\u12g4\"", "\"tab\there\"", "tru", "nul", "[1]]", "[\"a\"", "{} {}" })
+        CHECK_MESSAGE(!json::valid(bad), bad);
+
+    std::string deep(2000, '[');
+    deep += std::string(2000, ']');
+    json::value values[8];
+    json::tape tape(values);
+    CHECK(json::parse(deep, tape) == json::result::too_deep);
+    CHECK(json::parse(deep, tape, 4000) == json::result::tape_full);
+}
+
+TEST_CASE("test json strings"){
+    std::string out;
+    CHECK(json::unescape(R"(a\"b\\c\/d\n)", out));
+    CHECK(out == "a\"b\\c/d\n");
+    CHECK(json::unescape(R"(\u00e9\u4e2d\ud83c\udf89)", out));
+    CHECK(out == "\xc3\xa9\xe4\xb8\xad\xf0\x9f\x8e\x89");
+    CHECK(!json::unescape(R"(\ud83c)", out));
+    CHECK(!json::unescape(R"(\udf89)", out));
+
+    // the 8 byte scan stops at the right byte wherever it is
+    for (std::size_t n = 0; n < 20; ++n) {
+        std::string s = "\"" + std::string(n, 'x') + "\"";
+        CHECK(json::valid(s));
+        CHECK(!json::valid(s + "\""));
+        std::string with_escape = "\"" + std::string(n, 'x') + "\\\"" + std::string(n, 'y') + "\"";
+        CHECK(json::valid(with_escape));
+        std::string with_control = "\"" + std::string(n, 'x') + "\x01" + "\"";
+        CHECK(!json::valid(with_control));
+    }
+}
+
+}
@@ -0,0 +1,76 @@
+#include "limn.h"
+
+#include <cstdint>
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+enum : std::uint16_t { IDENT, NUMBER, PUNCT };
+
+auto lex = lexer_(
+    token_def_(IDENT, lexeme_(alpha_ >> *alnum_)),
+    token_def_(NUMBER, +digit_),
+    token_def_(PUNCT, charset_("<>(),;=*&:"))
+);
+
+// the token version of the template declaration grammar in test_parse_cxx.cpp
+auto template_single_arg = (kw_("class") | kw_("typename")) >> tok_(IDENT) >> opt_(kw_("=") >> tok_(IDENT));
+auto template_arg_list = template_single_arg % kw_(",");
+auto template_header = kw_("template") >> kw_("<") >> template_arg_list >> kw_(">");
+
+TEST_CASE("test lexing into tokens"){
+    token buffer[16];
+    token_stream tokens("", buffer, buffer);
+
+    CHECK(lex.tokenize("template <typename T>", buffer, 16, tokens));
+    CHECK(tokens.size() == 5);
+    CHECK(tokens.text(buffer[0]) == "template");
+    CHECK(buffer[0].kind == IDENT);
+    CHECK(buffer[1].kind == PUNCT);
+    CHECK(buffer[1].offset == 9);
+    CHECK(tokens.text(buffer[3]) == "T");
+
+    CHECK(lex.tokenize("  x12 = 42 ;  ", buffer, 16, tokens));
+    CHECK(tokens.size() == 4);
+    CHECK(buffer[2].kind == NUMBER);
+    CHECK(tokens.text(buffer[2]) == "42");
+
+    CHECK(lex.tokenize("", buffer, 16, tokens));
+    CHECK(tokens.empty());
+
+    // '@' matches no rule
+    CHECK(!lex.tokenize("a @ b", buffer, 16, tokens));
+    // not enough room
+    CHECK(!lex.tokenize("a b c", buffer, 2, tokens));
+}
+
+TEST_CASE("test parsing a token stream"){
+    token buffer[32];
+    token_stream tokens("", buffer, buffer);
+
+    REQUIRE(lex.tokenize("template <typename T, class U = int, typename X>", buffer, 32, tokens));
+    CHECK(parse(tokens, template_header >> end_));
+    CHECK(!parse(tokens, kw_("template") >> kw_(">")));
+
+    // keywords match whole tokens only
+    REQUIRE(lex.tokenize("templates <class T>", buffer, 32, tokens));
+    CHECK(!parse(tokens, template_header));
+
+    // the second alternative starts over at the same token, nothing is lexed again
+    REQUIRE(lex.tokenize("f ( a , b )", buffer, 32, tokens));
+    CHECK(parse(tokens, (tok_(IDENT) >> kw_("<")) | (tok_(IDENT) >> kw_("(") >> tok_(IDENT) >> *(kw_(",") >> tok_(IDENT)) >> kw_(")")) >> end_));
+
+    // matches are reported as source text, including the whitespace inside them
+    std::string_view args;
+    std::string args_seen;
+    auto collect = [&](const std::string_view& sv) { args_seen += std::string(sv) + "|"; };
+    CHECK(parse(tokens, tok_(IDENT) >> kw_("(") >> (tok_(IDENT)[collect] >> *(kw_(",") >> tok_(IDENT)[collect]))[args] >> kw_(")") >> end_));
+    CHECK(args == "a , b");
+    CHECK(args_seen == "a|b|");
+}
+
+}
@@ -0,0 +1,66 @@
+#include "limn.h"
+
+#include <functional>
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test limits match like parse"){
+    auto const grammar = *(lexeme_(+alpha_) >> opt_(char_(','))) >> end_;
+    CHECK(parse("one, two three", grammar, limits{}) == parse_result::matched);
+    CHECK(parse("one, 2", grammar, limits{}) == parse_result::no_match);
+    CHECK(parse("one, two three", grammar, limits{ 1000, 50 }, nosk) == parse_result::no_match);
+}
+
+TEST_CASE("test limits stop backtracking"){
+    // every alternative parses the same term again: 3^depth steps on ((((x))))
+    std::function<bool(impl::budget_view&)> expr_body;
+    auto expr = action_([&](auto& sv) { return expr_body(sv); });
+    auto term = (char_('(') >> expr >> char_(')')) | char_('x');
+    expr_body = [&](impl::budget_view& sv) {
+        return parse_ref(sv, (term >> char_('+') >> expr) | (term >> char_('-') >> expr) | term);
+    };
+
+    CHECK(parse("(x+x)-x", expr >> end_, limits{ 10000, 100 }) == parse_result::matched);
+    CHECK(parse("(x+x)-", expr >> end_, limits{ 10000, 100 }) == parse_result::no_match);
+
+    const std::string deep = std::string(20, '(') + "x" + std::string(20, ')');
+    CHECK(parse(deep, expr >> end_, limits{ 10000, 1000 }) == parse_result::out_of_steps);
+    // the same input with the budget to finish
+    CHECK(parse(std::string(6, '(') + "x" + std::string(6, ')'), expr >> end_, limits{ 100000000, 1000 }) == parse_result::matched);
+}
+
+TEST_CASE("test limits stop deep recursion"){
+    std::function<bool(impl::budget_view&)> nest_body;
+    auto nest = action_([&](auto& sv) { return nest_body(sv); });
+    nest_body = [&](impl::budget_view& sv) {
+        return parse_ref(sv, (char_('[') >> nest >> char_(']')) | empty_);
+    };
+
+    const std::string shallow = std::string(10, '[') + std::string(10, ']');
+    const std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    CHECK(parse(shallow, nest >> end_, limits{}) == parse_result::matched);
+    // would need a deep stack; the depth limit stops it first
+    CHECK(parse(deep, nest >> end_, limits{}) == parse_result::too_deep);
+    CHECK(parse(shallow, nest >> end_, limits{ 1000000, 20 }) == parse_result::too_deep);
+}
+
+TEST_CASE("test limits reject callbacks that take string_view"){
+    // given the budget_view as a std::string_view&, the parse_ref in the
+    // callback would parse on without limits, so these don't compile
+    auto sliced = [](std::string_view& sv) { return parse_ref(sv, char_('[')); };
+    static_assert(impl::sliced_callback<decltype(sliced)>::value);
+    static_assert(impl::sliced_callback<std::function<bool(std::string_view&)>>::value);
+    static_assert(impl::sliced_callback<bool (*)(std::string_view&)>::value);
+
+    auto generic = [](auto& sv) { return parse_ref(sv, char_('[')); };
+    static_assert(!impl::sliced_callback<decltype(generic)>::value);
+    static_assert(!impl::sliced_callback<std::function<bool(impl::budget_view&)>>::value);
+    CHECK(parse("[", action_([](auto& sv) { return parse_ref(sv, char_('[')); }) >> end_, limits{}) == parse_result::matched);
+}
+
+}
@@ -0,0 +1,68 @@
+#include "limn.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test line index"){
+    const std::string input = "first line\nsecond\r\n\nfourth, the long one past a word\nlast";
+    line_index lines(input);
+    CHECK(lines.lines() == 5);
+
+    CHECK(lines.locate(std::size_t(0)).line == 1);
+    CHECK(lines.locate(std::size_t(0)).column == 1);
+    // the newline is the last column of its line
+    CHECK(lines.locate(std::size_t(10)).line == 1);
+    CHECK(lines.locate(std::size_t(10)).column == 11);
+    CHECK(lines.locate(std::size_t(11)).line == 2);
+    CHECK(lines.locate(std::size_t(11)).column == 1);
+    CHECK(lines.locate(input.find("past")).line == 4);
+    CHECK(lines.locate(input.find("past")).column == 22);
+    // the end of the input is on the last line
+    CHECK(lines.locate(input.size()).line == 5);
+    CHECK(lines.locate(input.size()).column == 5);
+
+    CHECK(lines.line(1) == "first line");
+    CHECK(lines.line(2) == "second\r");
+    CHECK(lines.line(3).empty());
+    CHECK(lines.line(5) == "last");
+    CHECK(lines.line(6).empty());
+}
+
+TEST_CASE("test line index of matches"){
+    const std::string input = "a = 1\n"
+                              "  b = 22\n"
+                              "\n"
+                              "c = 333";
+    capture storage[8];
+    capture_buffer captures(storage);
+    auto const name = capture_(0, lexeme_(+alpha_));
+    REQUIRE(parse(input, *(name >> char_('=') >> lexeme_(+digit_)) >> end_, captures));
+    REQUIRE(captures.size() == 3);
+
+    line_index lines(input);
+    CHECK(lines.locate(captures.text(captures[1])).line == 2);
+    CHECK(lines.locate(captures.text(captures[1])).column == 3);
+    CHECK(lines.locate(captures.text(captures[2])).line == 4);
+    CHECK(lines.locate(captures.text(captures[2])).column == 1);
+}
+
+TEST_CASE("test line index without newlines"){
+    line_index empty("");
+    CHECK(empty.lines() == 1);
+    CHECK(empty.locate(std::size_t(0)).line == 1);
+    CHECK(empty.locate(std::size_t(0)).column == 1);
+
+    // newlines in every byte of a word, and in the tail
+    const std::string all(19, '\n');
+    line_index lines(all);
+    CHECK(lines.lines() == 20);
+    CHECK(lines.locate(std::size_t(8)).line == 9);
+    CHECK(lines.locate(std::size_t(8)).column == 1);
+}
+
+}
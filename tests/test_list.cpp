@@ -0,0 +1,62 @@
+#include "limn.h"
+
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test separated lists"){
+    auto number = lexeme_(+digit_);
+    CHECK(parse("1,2,3", number % char_(',') >> end_));
+    CHECK(parse("1 , 2 ,3", number % char_(',') >> end_));
+    CHECK(parse("7", list_(number, ',') >> end_));
+    CHECK(!parse("", list_(number, ',')));
+    CHECK(!parse("1 2", number % char_(',') >> end_));
+    CHECK(parse("1 :: 2::3", number % lit_("::") >> end_));
+
+    // a trailing separator is left for the rest of the grammar
+    std::string_view items;
+    CHECK(parse("1,2,;", (number % char_(','))[items] >> char_(',') >> char_(';') >> end_));
+    CHECK(items == "1,2");
+
+    std::vector<std::string_view> numbers;
+    std::size_t count = 0;
+    auto push = [&](std::string_view sv) { numbers.push_back(sv); };
+    auto collect = list_(number[push], ';', count);
+    CHECK(parse("10; 20; 30", collect >> end_));
+    CHECK(count == 3);
+    CHECK(numbers.size() == 3);
+    CHECK(numbers[2] == "30");
+
+    std::string_view arg;
+    auto template_args = (lit_("class") >> lexeme_(+alnum_)[arg]) % char_(',');
+    CHECK(parse("class T, class U", template_args >> end_));
+    CHECK(arg == "U");
+}
+
+TEST_CASE("test list element bound"){
+    auto word = lexeme_(+alpha_);
+    CHECK(list_(word, ',').max_count("") == 1);
+    CHECK(list_(word, ',').max_count("a,b,c") == 3);
+    CHECK(list_(word, lit_(", ")).max_count("a, b,c, d") == 3);
+    CHECK(list_(word, lit_(", ") | lit_(";")).max_count("a, b;c") == 3);
+
+    // reserve once, then fill
+    std::string input;
+    for (int i = 0; i < 1000; ++i)
+        input += i ? ",x" : "x";
+    std::vector<std::string_view> words;
+    auto push = [&](std::string_view sv) { words.push_back(sv); };
+    auto list = list_(word[push], ',');
+    words.reserve(list.max_count(input));
+    const auto capacity = words.capacity();
+    CHECK(parse(input, list >> end_, nosk));
+    CHECK(words.size() == 1000);
+    CHECK(words.capacity() == capacity);
+}
+
+}
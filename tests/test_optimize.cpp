@@ -0,0 +1,109 @@
+#include "limn.h"
+
+#include <string>
+#include <type_traits>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test optimize merges alternatives"){
+    constexpr auto sign = optimize(char_('+') | char_('-') | range_('0', '9'));
+    static_assert(std::is_same_v<std::decay_t<decltype(sign)>, impl::alt_<impl::set_>>);
+    constexpr auto digit = optimize(lexeme_(range_('0', '9') | char_('_')));
+    static_assert(std::is_same_v<std::decay_t<decltype(digit)>, impl::set_>);
+    CHECK(parse("-", sign >> end_));
+    CHECK(parse("7", sign >> end_));
+    CHECK(!parse("x", sign));
+
+    constexpr auto keyword = optimize(lit_("int") | lit_("in") | lit_("if") | lit_(""));
+    static_assert(std::is_same_v<std::decay_t<decltype(keyword)>, impl::alt_<impl::lits_<4>>>);
+    std::string_view word;
+    CHECK(parse("int x", keyword[word], nosk));
+    CHECK(word == "int");
+    CHECK(parse("inx", keyword[word], nosk));
+    CHECK(word == "in");
+    CHECK(parse("if", keyword[word], nosk));
+    CHECK(word == "if");
+    CHECK(parse("x", keyword[word], nosk));
+    CHECK(word.empty());
+
+    // only neighbours are merged, and the first match still wins
+    auto mixed = optimize(char_('a') | lit_("ab") | char_('b') | charset_("cd") | lit_("e") | lit_("ef"));
+    CHECK(parse("ab", mixed >> end_) == parse("ab", (char_('a') | lit_("ab")) >> end_));
+    CHECK(parse("d", mixed >> end_));
+    CHECK(parse("e", mixed >> end_));
+    CHECK(!parse("ef", mixed >> end_));
+
+    // alternatives after empty_ are never tried
+    auto dead = optimize(lit_("a") | empty_ | lit_("b"));
+    static_assert(std::is_same_v<decltype(dead), impl::alt_<lit_, impl::emptytype_>>);
+}
+
+TEST_CASE("test optimize collapses no-ops"){
+    auto a = char_('a');
+    static_assert(std::is_same_v<decltype(optimize(opt_(*a))), impl::kleene_<char_>>);
+    static_assert(std::is_same_v<decltype(optimize(opt_(opt_(a)))), opt_<char_>>);
+    static_assert(std::is_same_v<decltype(optimize(empty_ >> a)), impl::seq_<char_>>);
+    static_assert(std::is_same_v<decltype(optimize(lexeme_(empty_ >> a >> empty_))), char_>);
+    static_assert(std::is_same_v<decltype(optimize(lexeme_(lexeme_(*a)))), lexeme_<impl::kleene_<char_>>>);
+    static_assert(std::is_same_v<decltype(optimize(empty_ >> empty_)), impl::seq_<impl::emptytype_>>);
+
+    // named parts are flattened into the copy, the trailing empty_ stays
+    auto ab = a >> char_('b');
+    static_assert(std::is_same_v<decltype(optimize(ab >> empty_ >> ab)), impl::seq_<char_, char_, char_, char_>>);
+    static_assert(std::is_same_v<decltype(optimize(ab >> empty_)), impl::seq_<char_, char_, impl::emptytype_>>);
+    CHECK(parse("ab ab", optimize(ab >> empty_ >> ab) >> end_));
+    CHECK(parse("@", optimize(*(*alnum_) >> char_('@')) >> end_));
+}
+
+TEST_CASE("test optimize skips where the grammar skips"){
+    auto a = char_('a');
+    auto same = [](std::string_view text, auto const& grammar) {
+        std::string_view plain, optimized;
+        const bool matched = parse(text, grammar[plain]);
+        CHECK(parse(text, optimize(grammar)[optimized]) == matched);
+        CHECK(optimized == plain);
+    };
+    for (std::string_view text : { "aa aa", "a a", " a", "a   ", "ab b", "a b a", "" }) {
+        same(text, *(*a) >> end_);
+        same(text, +(*a) >> end_);
+        same(text, *(+a) >> end_);
+        same(text, +(+a) >> end_);
+        same(text, opt_(+a) >> end_);
+        same(text, *(a | char_('b')) >> end_);
+        same(text, *(empty_ >> a) >> end_);
+        same(text, *(lit_("a") | lit_("b")) >> end_);
+        same(text, a >> empty_);
+        same(text, lit_("a") >> empty_);
+        same(text, *lexeme_(a | char_('b')) >> end_);
+    }
+}
+
+TEST_CASE("test optimize keeps callbacks and captures"){
+    std::string calls;
+    auto on = [&](char const* name) {
+        return std::function<void(const std::string_view&)>([&calls, name](const std::string_view& sv) {
+            calls += name;
+            calls += std::string(sv) + " ";
+        });
+    };
+    auto grammar = *(((char_('a')[on("a")] >> char_('b')) | (char_('a') >> (char_('e') | char_('f'))[on("e")])) >> char_('c'));
+    const std::string expected = (parse("aec abc", grammar), calls);
+    calls.clear();
+    CHECK(parse("aec abc", optimize(grammar)));
+    CHECK(calls == expected);
+
+    enum : std::uint32_t { KEY };
+    capture slots[4];
+    capture_buffer captures(slots);
+    std::string_view all;
+    CHECK(parse("x y", optimize(*capture_(KEY, charset_("xy") | char_('z')))[all], captures));
+    CHECK(captures.size() == 2);
+    CHECK(captures.text(captures[1]) == "y");
+    CHECK(all == "x y");
+}
+
+}
@@ -0,0 +1,69 @@
+#include "limn.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+// text followed by lm::padding zero bytes
+struct padded_buffer {
+    explicit padded_buffer(std::string text)
+        : size(text.size())
+        , data(std::move(text))
+    {
+        data.append(padding, '\0');
+    }
+
+    padded input() const { return padded(std::string_view(data.data(), size)); }
+
+    std::size_t size;
+    std::string data;
+};
+
+template <typename Parser>
+void check_same(std::string const& text, Parser const& parser) {
+    padded_buffer buffer(text);
+    INFO(text);
+    CHECK(parse(buffer.input(), parser) == parse(text, parser));
+}
+
+TEST_CASE("test padded input matches like plain input"){
+    auto const number = lexeme_(+digit_);
+    auto const list = number >> *(char_(',') >> number) >> end_;
+    for (char const* text : { "", "1", "12,345", "1,2,3,", "123456789012345678901,7", ",1", "9x" })
+        check_same(text, list);
+
+    auto const words = *(lexeme_(+alpha_) >> opt_(char_(';'))) >> end_;
+    for (char const* text : { "", "a", "abc;def", "abc;;", "one two three" })
+        check_same(text, words);
+
+    auto const keywords = *(lit_("while") | lit_("whilst") | lit_("a-rather-long-keyword") | ilit_("END")) >> end_;
+    for (char const* text : { "while whilst", "whil", "end END", "a-rather-long-keyword", "a-rather-long-keywor", "whilst whi" })
+        check_same(text, keywords);
+}
+
+TEST_CASE("test padded input stops at the end"){
+    // a class that takes '\0' can't rely on the padding to stop it
+    padded_buffer buffer("ab");
+    std::string_view rest;
+    CHECK(parse(buffer.input(), (*!char_('x'))[rest] >> end_));
+    CHECK(rest == "ab");
+    CHECK(parse(buffer.input(), lexeme_(+!range_('0', '9')) >> end_));
+
+    // a literal with '\0' in it doesn't match the padding
+    CHECK(!parse(buffer.input(), lit_(std::string_view("ab\0", 3))));
+
+    // every length around a word, for the word at a time scans
+    for (std::size_t n = 0; n < 20; ++n) {
+        padded_buffer digits(std::string(n, '7'));
+        std::string_view match;
+        CHECK(parse(digits.input(), (*digit_)[match] >> end_));
+        CHECK(match.size() == n);
+        CHECK(parse(digits.input(), +char_('7') >> end_) == (n != 0));
+    }
+}
+
+}
@@ -44,7 +44,7 @@ auto qualified_name = opt_(lit_("::")) >> scope_name >> *( lit_("::") >> scope_n
 
 
 auto template_single_arg = (lit_("class") | lit_("typename")) >> id >> opt_((char_('=') >> id));
-auto template_arg_list = template_single_arg[p] >> *(char_(',') >> template_single_arg);
+auto template_arg_list = template_single_arg[p] % char_(',');
 
 auto pointer_reference_const_qualifier = *(lit_("const") | lit_("*") | lit_("&"));
 
@@ -138,3 +138,24 @@ TEST_CASE("testing of parrsing the C++ code") {
     }
 
 }
+
+TEST_CASE("parsing C++ with comments") {
+    // whitespace and comments are skipped between the tokens
+    CHECK(parse("template <typename T> // the element type\n"
+                "T /* returns */ A::B::fun(/* nothing */);", template_function_declaration_grammar >> end_, skcomments));
+    CHECK(parse("template <typename T, /* defaulted */ class U = int>\n"
+                "// a declaration\n"
+                "// over several lines\n"
+                "T A::fun(T x, U y); // trailing", template_function_declaration_grammar >> end_, skcomments));
+    CHECK(!parse("template <typename T> T fun(); // trailing", template_function_declaration_grammar >> end_));
+
+    // an unterminated block comment is not skipped
+    CHECK(!parse("template <typename T> T fun(); /* trailing", template_function_declaration_grammar >> end_, skcomments));
+
+    // other comment syntaxes
+    SkipComments shell("#", "", "");
+    CHECK(parse("a = 1 # one\n# nothing\nb = 2", +(id >> char_('=') >> id) >> end_, shell));
+    SkipComments haskell("--", "{-", "-}");
+    CHECK(parse("f {- the - function -} x -- applied", id >> id >> end_, haskell));
+    CHECK(!parse("f /* x */", id >> end_, haskell));
+}
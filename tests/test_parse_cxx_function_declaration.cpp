@@ -55,7 +55,7 @@ auto qualified_name = opt_(lit_("::")) >> scope_name >> *( lit_("::") >> scope_n
 
 
 auto template_single_arg = (lit_("class") | lit_("typename")) >> ident >> opt_(char_('=') >> ident);
-auto template_arg_list = template_single_arg[p] >> *(char_(',') >> template_single_arg);
+auto template_arg_list = template_single_arg[p] % char_(',');
 
 constexpr
 auto pointer_reference_const_qualifier = *(lit_("const") | lit_("*") | lit_("&"));
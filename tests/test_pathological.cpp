@@ -0,0 +1,104 @@
+#include "pathological.h"
+
+#include <functional>
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+// expressions like ((x+x)-x); nest deeper as n grows
+std::string nested(std::size_t n) {
+    std::string input = "x";
+    while (input.size() + 4 <= n)
+        input = "(" + input + "+x)";
+    return input;
+}
+
+// ((((x)))); nest deeper as n grows
+std::string parens(std::size_t n) {
+    const std::size_t depth = n > 1 ? (n - 1) / 2 : 0;
+    return std::string(depth, '(') + "x" + std::string(depth, ')');
+}
+
+TEST_CASE("test a linear grammar passes"){
+    lm_test::profile prof;
+    std::function<bool(std::string_view&)> expr_body;
+    auto expr = lm_test::rule(prof, "expr", action_([&](std::string_view& sv) { return expr_body(sv); }));
+    auto term = lm_test::rule(prof, "term", (char_('(') >> expr >> char_(')')) | char_('x'));
+    // each term is parsed once, then the operator decides
+    expr_body = [&](std::string_view& sv) { return parse_ref(sv, term >> opt_(charset_("+-") >> expr)); };
+
+    auto report = lm_test::check_growth(prof, expr >> end_, nested);
+    INFO(report.message);
+    CHECK(report.ok);
+    CHECK(report.exponent < 1.2);
+
+    lm_test::growth_options fuzzing;
+    fuzzing.alphabet = "()+-x";
+    fuzzing.seeds = { "(x+", "x-" };
+    report = lm_test::check_growth(prof, expr >> end_, nullptr, fuzzing);
+    INFO(report.message);
+    CHECK(report.ok);
+}
+
+TEST_CASE("test exponential backtracking is caught"){
+    lm_test::profile prof(2000000);
+    std::function<bool(std::string_view&)> expr_body;
+    auto expr = lm_test::rule(prof, "expr", action_([&](std::string_view& sv) { return expr_body(sv); }));
+    auto term = lm_test::rule(prof, "term", (char_('(') >> expr >> char_(')')) | char_('x'));
+    // every alternative parses the same term again: 3^depth
+    expr_body = [&](std::string_view& sv) {
+        return parse_ref(sv, (term >> char_('+') >> expr) | (term >> char_('-') >> expr) | term);
+    };
+
+    // fine while every first alternative works...
+    auto report = lm_test::check_growth(prof, expr >> end_, nested);
+    INFO(report.message);
+    CHECK(report.ok);
+
+    // ...but not when the last one is needed at every level
+    report = lm_test::check_growth(prof, expr >> end_, parens);
+    INFO(report.message);
+    CHECK(!report.ok);
+    CHECK(report.rule == "term");
+    CHECK(report.message.find("limit reached") != std::string::npos);
+
+    // fuzzing finds the nesting by itself
+    lm_test::growth_options fuzzing;
+    fuzzing.alphabet = "()+x";
+    fuzzing.seeds = { "x", "(" };
+    fuzzing.sizes = { 8, 16, 32, 64 };
+    report = lm_test::check_growth(prof, expr >> end_, nullptr, fuzzing);
+    INFO(report.message);
+    CHECK(!report.ok);
+}
+
+TEST_CASE("test quadratic rescanning is caught"){
+    lm_test::profile prof;
+    // at every 'a', looks for a closing 'b' to the end of the input
+    auto quoted = lm_test::rule(prof, "quoted", lexeme_(char_('a') >> *char_('a') >> char_('b')));
+    auto plain = lm_test::rule(prof, "plain", char_('a'));
+    auto document = *(quoted | plain) >> end_;
+
+    auto report = lm_test::check_growth(prof, document, [](std::size_t n) { return std::string(n, 'a'); });
+    INFO(report.message);
+    CHECK(!report.ok);
+    CHECK(report.rule == "quoted");
+    CHECK(report.exponent > 1.8);
+    CHECK(report.exponent < 2.2);
+
+    // the same rule is fine when the input closes every run
+    report = lm_test::check_growth(prof, document, [](std::size_t n) {
+        std::string input;
+        while (input.size() < n)
+            input += "aaab";
+        return input;
+    });
+    INFO(report.message);
+    CHECK(report.ok);
+}
+
+}
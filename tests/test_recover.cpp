@@ -0,0 +1,75 @@
+#include "limn.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test recover skips bad records to the sync token"){
+    auto const record = lexeme_(+alpha_) >> char_('=') >> lexeme_(+digit_) >> char_(';');
+    std::vector<std::string_view> errors;
+    std::vector<std::string_view> keys;
+    std::string_view key;
+    auto const grammar = *recover_(lexeme_(+alpha_)[key] >> char_('=') >> lexeme_(+digit_) >> char_(';') >> action_([&](std::string_view&) {
+        keys.push_back(key);
+        return true;
+    }), char_(';'), errors) >> end_;
+
+    CHECK(parse("a=1; b=x2; c=3; d=4 e=5; f=6;", grammar));
+    REQUIRE(keys.size() == 3);
+    CHECK(keys[0] == "a");
+    CHECK(keys[1] == "c");
+    CHECK(keys[2] == "f");
+    REQUIRE(errors.size() == 2);
+    CHECK(errors[0] == "b=x2");
+    CHECK(errors[1] == "d=4 e=5");
+
+    // without recover_ the first bad record fails the parse
+    CHECK_FALSE(parse("a=1; b=x2; c=3;", *record >> end_));
+}
+
+TEST_CASE("test recover at the end of the input"){
+    std::vector<std::string_view> errors;
+    auto const line = recover_(lexeme_(+digit_ >> char_('\n')), char_('\n'), errors);
+
+    // no sync token left: the rest is the error
+    CHECK(parse("12\n3x4", *line >> end_, nosk));
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0] == "3x4");
+
+    // an empty bad record moves past its sync token and records nothing
+    errors.clear();
+    CHECK(parse("\n5\n", *line >> end_, nosk));
+    CHECK(errors.empty());
+
+    // nothing to skip at the end, so recover_ fails there
+    errors.clear();
+    std::string_view empty;
+    CHECK_FALSE(line.visit(empty, nosk));
+    CHECK(errors.empty());
+}
+
+TEST_CASE("test recover skips blank lines without an error"){
+    std::vector<std::string_view> errors;
+    auto const record = recover_(lit_("ab") >> char_('\n'), char_('\n'), errors);
+    CHECK(parse("ab\n\nzz\nab\n", *record >> end_, nosk));
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0] == "zz");
+}
+
+TEST_CASE("test recover with a sync token of several bytes"){
+    std::vector<std::string_view> errors;
+    auto const block = char_('[') >> *digit_ >> lit_("]]");
+    auto const grammar = *recover_(block, lit_("]]"), errors) >> end_;
+
+    CHECK(parse("[12]][3]x]][4]]", grammar, nosk));
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0] == "[3]x");
+}
+
+}
@@ -0,0 +1,88 @@
+#include "limn.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test fixed repetition"){
+    auto date = repeat_<4>(digit_) >> char_('-') >> repeat_<2>(digit_) >> char_('-') >> repeat_<2>(digit_);
+    CHECK(parse("2024-01-31", date >> end_, nosk));
+    CHECK(!parse("2024-1-31", date, nosk));
+    CHECK(!parse("202-01-31", date, nosk));
+    CHECK(!parse("2024-01-3", date, nosk));
+
+    auto hex = range_('0', '9') | range_('a', 'f');
+    auto uuid = repeat_<8>(hex) >> char_('-') >> repeat_<4>(hex) >> char_('-') >> repeat_<4>(hex)
+        >> char_('-') >> repeat_<4>(hex) >> char_('-') >> repeat_<12>(hex);
+    CHECK(parse("123e4567-e89b-12d3-a456-426614174000", uuid >> end_, nosk));
+    CHECK(!parse("123e4567-e89b-12d3-a456-42661417400", uuid >> end_, nosk));
+    CHECK(!parse("123e4567-e89b-12d3-a456-42661417400g", uuid >> end_, nosk));
+
+    std::string_view code;
+    CHECK(parse("\\x41 rest", lit_("\\x") >> repeat_<2>(range_('0', '9') | range_('A', 'F'))[code]));
+    CHECK(code == "41");
+    CHECK(!parse("", repeat_<1>(char_('a'))));
+    CHECK(parse("", repeat_<0>(char_('a')) >> end_));
+
+    // zero repetitions match the empty prefix of a word-sized input too
+    CHECK(parse("0123456789", repeat_<0>(digit_) >> lit_("0123"), nosk));
+    CHECK(parse("abcdefghij", repeat_<0>(range_('0', '9')) >> lit_("abc"), nosk));
+    CHECK(parse("abcdefghij", repeat_(0, range_('0', '9')) >> lit_("abc"), nosk));
+}
+
+TEST_CASE("test bounded repetition"){
+    std::string_view digits;
+    CHECK(parse("12345", repeat_<1, 3>(digit_)[digits], nosk));
+    CHECK(digits == "123");
+    CHECK(parse("7x", repeat_<1, 3>(digit_)[digits] >> char_('x'), nosk));
+    CHECK(digits == "7");
+    CHECK(!parse("x", repeat_<1, 3>(digit_), nosk));
+    CHECK(parse("aaaaaaaaaa", repeat_<0, unbounded>(char_('a')) >> end_));
+
+    // the count can come from the input
+    CHECK(parse("abcdef", repeat_(6, range_('a', 'z')) >> end_, nosk));
+    CHECK(!parse("abcde", repeat_(6, range_('a', 'z')), nosk));
+    CHECK(parse("ababab", repeat_(2, 3, lit_("ab")) >> end_));
+    CHECK(!parse("ababab", repeat_(1, 2, lit_("ab")) >> end_));
+
+    // composite items skip whitespace on entry, like the Kleene star
+    CHECK(parse("1 2 3", repeat_<3>(lexeme_(digit_) >> empty_) >> end_));
+    CHECK(!parse("1 2 3", repeat_<3>(digit_) >> end_));
+    CHECK(parse("a a", repeat_<3>(range_(' ', 'z')) >> end_));
+    // a failed item is rewound
+    CHECK(parse("ab ab ac", repeat_<1, 3>(char_('a') >> char_('b')) >> lit_("ac")));
+}
+
+TEST_CASE("test fixed width checks agree with the loop"){
+    // every width, alignment and position of a bad character
+    const std::string good(40, '5');
+    int mismatches = 0;
+    for (std::size_t n = 0; n <= 20; ++n) {
+        for (std::size_t offset = 0; offset < 8; ++offset) {
+            for (std::size_t bad = 0; bad <= n + 1; ++bad) {
+                for (char ch : { '/', ':', 'a', '\x85', ' ' }) {
+                    std::string input = good.substr(0, offset + n + 2);
+                    if (offset + bad < input.size())
+                        input[offset + bad] = ch;
+                    std::string_view const sv = std::string_view(input).substr(offset, n + (bad & 1));
+                    std::string_view fast = sv;
+                    std::string_view slow = sv;
+                    const bool a = repeat_(n, digit_).visit(fast, nosk);
+                    const bool b = repeat_(n, n, char_if_([](char c) { return '0' <= c && c <= '9'; })).visit(slow, nosk);
+                    if (a != b || fast.size() != slow.size())
+                        ++mismatches;
+                    std::string_view same = sv;
+                    if (repeat_(n, char_('5')).visit(same, nosk) != b)
+                        ++mismatches;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+}
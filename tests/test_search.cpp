@@ -0,0 +1,87 @@
+#include "limn.h"
+
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+template <typename Parser>
+std::vector<std::string> matches(std::string_view input, Parser const& parser, Skipper& skipper = skws) {
+    std::vector<std::string> found;
+    find_all(input, parser, [&](std::string_view sv) { found.emplace_back(sv); }, skipper);
+    return found;
+}
+
+TEST_CASE("test searching with a literal prefix"){
+    const std::string log =
+        "10:01 GET /index.html 200\n"
+        "10:02 POST /form 302\n"
+        "10:03 GET /style.css 200\n";
+
+    auto request = lit_("GET ") >> lexeme_(+graph_);
+    CHECK(matches(log, request) == std::vector<std::string>{ "GET /index.html", "GET /style.css" });
+    CHECK(matches(log, lit_("PUT ")).empty());
+    CHECK(matches("", request).empty());
+
+    // lazily, one match at a time
+    searcher_ finder(request);
+    std::string_view input = log;
+    std::string_view match;
+    REQUIRE(finder.next(input, match));
+    CHECK(match == "GET /index.html");
+    CHECK(input.substr(0, 4) == " 200");
+    REQUIRE(finder.next(input, match));
+    CHECK(match == "GET /style.css");
+    CHECK(!finder.next(input, match));
+    CHECK(input.empty());
+}
+
+TEST_CASE("test searching keeps the trailing skip"){
+    // the match ends where the grammar stopped, after the skipped text
+    CHECK(matches("x a b  c", lit_("a") >> *lit_("b") >> opt_(lit_("z"))) == std::vector<std::string>{ "a b  " });
+    CHECK(matches("a b", lit_("a") >> opt_(lit_("zz"))) == std::vector<std::string>{ "a " });
+    CHECK(matches("a b", lit_("a") >> opt_(lit_("zz")), nosk) == std::vector<std::string>{ "a" });
+}
+
+TEST_CASE("test searching with character classes"){
+    auto number = lexeme_(+digit_);
+    CHECK(matches("a1 bb22 ccc333", number) == std::vector<std::string>{ "1", "22", "333" });
+
+    // matches don't overlap, and a match that fails part way doesn't hide a later one
+    auto call = lexeme_(alpha_ >> *alnum_) >> char_('(') >> char_(')');
+    CHECK(matches("x = f(); g (); h(1); k()", call) == std::vector<std::string>{ "f()", "g ()", "k()" });
+    CHECK(matches("aaaa", lit_("aa")) == std::vector<std::string>{ "aa", "aa" });
+
+    // a leading optional part widens the set of start bytes
+    auto integer = opt_(char_('-')) >> lexeme_(+digit_);
+    CHECK(matches("x-1 y2 -z", integer, nosk) == std::vector<std::string>{ "-1", "2" });
+
+    CHECK(matches("ab AB aB", ilit_("ab")) == std::vector<std::string>{ "ab", "AB", "aB" });
+    CHECK(matches("a,b;c", charset_(",;")) == std::vector<std::string>{ ",", ";" });
+
+    // a negated class adds to the bytes of its siblings, it doesn't replace them
+    CHECK(matches("aaa", char_('a') | !char_('a')) == std::vector<std::string>{ "a", "a", "a" });
+    CHECK(matches("xy", opt_(char_('x')) >> !char_('x'), nosk) == std::vector<std::string>{ "xy" });
+}
+
+TEST_CASE("test searching with empty matches and actions"){
+    // *char_ can match empty, only the non-empty matches are reported
+    CHECK(matches("xaaxxa", *char_('a')) == std::vector<std::string>{ "aa", "a" });
+    CHECK(matches("xyz", *char_('a')).empty());
+
+    // an action_ could start anywhere, so every position is tried
+    auto twice = action_([](std::string_view& sv) {
+        if (sv.size() >= 2 && sv[0] == sv[1]) {
+            sv.remove_prefix(2);
+            return true;
+        }
+        return false;
+    });
+    CHECK(matches("abccdeef", twice) == std::vector<std::string>{ "cc", "ee" });
+}
+
+}
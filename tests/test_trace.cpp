@@ -0,0 +1,74 @@
+#include "limn_trace.h"
+
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+// records the events as text, to check their order
+struct recorder {
+    void enter(rule_info const& rule, std::size_t offset) {
+        out += std::string(rule.name) + "@" + std::to_string(offset) + " ";
+    }
+    void exit(rule_info const& rule, std::size_t begin, std::size_t end) {
+        out += "/" + std::string(rule.name) + "@" + std::to_string(begin) + "-" + std::to_string(end) + " ";
+    }
+    void fail(rule_info const& rule, std::size_t begin) {
+        out += "!" + std::string(rule.name) + "@" + std::to_string(begin) + " ";
+    }
+    std::string out;
+};
+
+TEST_CASE("test trace events"){
+    recorder rec;
+    CHECK(parse_traced("ac", char_('a') >> (char_('b') | char_('c')), rec));
+    CHECK(rec.out == "seq_@0 char_@0 /char_@0-1 alt_@1 char_@1 !char_@1 char_@1 /char_@1-2 /alt_@1-2 /seq_@0-2 ");
+
+    // a combinator enters before it skips, its children after
+    rec.out.clear();
+    CHECK(!parse_traced(" a  x", lit_("a") >> lit_("b"), rec));
+    CHECK(rec.out == "seq_@0 lit_@1 /lit_@1-2 lit_@4 !lit_@4 !seq_@0 ");
+
+    // a traced parse matches like an untraced one
+    auto const grammar = *(lexeme_(+alpha_) >> opt_(char_(',')));
+    rec.out.clear();
+    CHECK(parse_traced("one, two three", grammar >> end_, rec) == parse("one, two three", grammar >> end_));
+    CHECK(!rec.out.empty());
+}
+
+TEST_CASE("test trace flame graph"){
+    trace::flame_graph flame;
+    auto const grammar = *(lit_("ab") | lit_("ac"));
+    CHECK(parse_traced("ab ac ac", grammar >> end_, flame));
+    CHECK(flame.count("seq_") == 1);
+    CHECK(flame.count("seq_;kleene_") == 1);
+    // "ac" is only tried after "ab" failed
+    CHECK(flame.count("seq_;kleene_;alt_") == 3);
+    CHECK(flame.count("seq_;kleene_;alt_;lit_") == 1 + 2 + 2);
+    CHECK(flame.folded().find("seq_;endtype_ 1\n") != std::string::npos);
+}
+
+TEST_CASE("test trace event log"){
+    trace::event_log log;
+    CHECK(parse_traced("xy", char_('x') >> char_('y'), log));
+
+    std::vector<trace::kind> kinds;
+    std::string names;
+    CHECK(trace::replay(log.bytes(), [&](trace::event const& e, std::string_view name) {
+        kinds.push_back(e.what);
+        names += std::string(name) + ":" + std::to_string(e.begin) + "-" + std::to_string(e.end) + " ";
+    }));
+    CHECK(kinds.size() == 6);
+    CHECK(kinds.front() == trace::kind::enter);
+    CHECK(kinds.back() == trace::kind::exit);
+    CHECK(names == "seq_:0-0 char_:0-0 char_:0-1 char_:1-1 char_:1-2 seq_:0-2 ");
+
+    // a cut log is reported
+    CHECK(!trace::replay(log.bytes().substr(0, log.bytes().size() - 1), [](trace::event const&, std::string_view) {}));
+}
+
+}
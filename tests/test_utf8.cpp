@@ -0,0 +1,95 @@
+#include "limn_utf8.h"
+
+#include <string>
+
+#include <doctest/doctest.h>
+
+namespace {
+
+using namespace lm; // Laziness
+
+TEST_CASE("test code point parsers"){
+    CHECK(parse("é", u8char_(U'é') >> end_));
+    CHECK(parse("中", u8char_() >> end_));
+    CHECK(!parse("e", u8char_(U'é')));
+    CHECK(parse("β", u8range_(U'α', U'ω') >> end_));
+    CHECK(!parse("Ω", u8range_(U'α', U'ω')));
+
+    // the byte parsers split code points, these don't
+    std::string_view word;
+    CHECK(parse("naïve café", (+!u8char_(U' '))[word] >> u8char_(U' '), nosk));
+    CHECK(word == "naïve");
+    CHECK(parse("ÿ", !u8range_(U'a', U'z') >> end_));
+
+    // malformed sequences never match
+    CHECK(!parse("\xc3", u8char_()));          // truncated
+    CHECK(!parse("\xc0\xaf", u8char_()));      // overlong '/'
+    CHECK(!parse("\xed\xa0\x80", u8char_()));  // surrogate
+    CHECK(!parse("\xf4\x90\x80\x80", u8char_())); // past U+10FFFF
+    CHECK(!parse("\x80", !u8char_(U'x')));
+}
+
+TEST_CASE("test unicode identifiers"){
+    auto ident = lexeme_(u8id_start_ >> *u8id_continue_);
+    std::string_view name;
+    CHECK(parse("переменная = 1", ident[name] >> char_('=')));
+    CHECK(name == "переменная");
+    CHECK(parse("變數_2", ident >> end_));
+    CHECK(parse("x́", ident >> end_));  // combining accent continues
+    CHECK(!parse("2x", ident));
+    CHECK(!parse("́x", ident));         // but can't start
+    CHECK(!parse("_x", ident));
+    CHECK(parse("Straße", +u8letter_ >> end_));
+    CHECK(!parse("€", u8letter_));
+
+    std::string found;
+    find_all("a := Δx + 3·y", ident, [&](std::string_view sv) { found += std::string(sv) + "|"; });
+    CHECK(found == "a|Δx|y|");
+}
+
+TEST_CASE("test utf8 validation"){
+    CHECK(utf8_valid(""));
+    CHECK(utf8_valid("plain ascii text that is longer than sixteen bytes"));
+    CHECK(utf8_valid("κόσμε, 世界, 🎉 and 𝔘𝔫𝔦𝔠𝔬𝔡𝔢 spread over several 16 byte blocks"));
+    CHECK(!utf8_valid("abc\xff"));
+    CHECK(!utf8_valid("0123456789abcde\xe4\xb8"));  // truncated at the end
+    CHECK(!utf8_valid("0123456789abcdef\x80"));
+    CHECK(parse_utf8("größe", +u8letter_ >> end_));
+    CHECK(!parse_utf8("gr\xf6\xdf" "e", *char_if_([](char) { return true; })));
+
+    // every sequence of up to 3 bytes from a set that covers each boundary,
+    // at every offset in a block, agrees with the code point decoder
+    const unsigned char bytes[] = { 0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2,
+        0xdf, 0xe0, 0xe1, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf3, 0xf4, 0xf5, 0xff };
+    int mismatches = 0;
+    for (unsigned char a : bytes) {
+        for (unsigned char b : bytes) {
+            for (unsigned char c : bytes) {
+                for (unsigned char d : { 0x80, 0xbf, 0x41 }) {
+                    const char seq[] = { char(a), char(b), char(c), char(d) };
+                    std::string input(13, 'x');
+                    input.append(seq, 4);
+                    bool expected = true;
+                    std::string_view rest(seq, 4);
+                    while (!rest.empty()) {
+                        char32_t cp = 0;
+                        std::size_t n = impl::u8decode(rest, cp);
+                        if (n == 0) {
+                            expected = false;
+                            break;
+                        }
+                        rest.remove_prefix(n);
+                    }
+                    for (std::size_t shift = 0; shift < 14; ++shift) {
+                        std::string_view sv = std::string_view(input).substr(shift);
+                        if (utf8_valid(sv) != expected || impl::utf8_valid_scalar(sv.data(), sv.size()) != expected)
+                            ++mismatches;
+                    }
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+}
@@ -1,6 +1,8 @@
 #include "limn.h"
 
 #include <cassert>
+#include <cstring>
+#include <memory>
 #include <string>
 
 #include <iostream> // std::cout
@@ -54,6 +56,14 @@ constexpr bool validParenthesesHelper(std::string_view sv) {
     return validParentheses(sv);
 }
 
+// parse_ref stays usable in constant expressions
+constexpr bool parseRefAtCompileTime() {
+    std::string_view sv = "abc";
+    NoSkip skipper;
+    return parse_ref(sv, lit_("ab"), skipper) && sv == "c";
+}
+static_assert(parseRefAtCompileTime());
+
 bool oneTwoThree(std::string_view sv) {
     return parse(sv, lit_("one") >> (lit_("two") | empty_) >> lit_("three") >> end_);
 }
@@ -101,3 +111,70 @@ TEST_CASE("test simple text parsing"){
     CHECK(parse("hello", lit_("hello") >> opt_(lit_("world")) >> end_));
 }
 
+
+TEST_CASE("test flattened chains"){
+    // unnamed chains become one node
+    static_assert(std::is_same_v<decltype(char_('a') >> char_('b') >> char_('c')), impl::seq_<char_, char_, char_>>);
+    static_assert(std::is_same_v<decltype(lit_("a") | lit_("b") | lit_("c")), impl::alt_<lit_, lit_, lit_>>);
+
+    // named rules are referenced, not flattened
+    auto ab = char_('a') >> char_('b');
+    static_assert(std::is_same_v<decltype(ab >> char_('c')), impl::seq_<decltype(ab)&, char_>>);
+
+    CHECK(parse("a b c", char_('a') >> char_('b') >> char_('c') >> end_));
+    CHECK(parse("abc", ab >> char_('c') >> end_));
+    CHECK(!parse("abd", ab >> char_('c') >> end_));
+    CHECK(parse("c", lit_("a") | lit_("b") | lit_("c")));
+    CHECK(!parse("d", lit_("a") | lit_("b") | lit_("c")));
+    CHECK(parse("xbc", (lit_("xa") | lit_("xb") | lit_("xc")) >> char_('c') >> end_));
+}
+
+TEST_CASE("test literals of every length"){
+    const std::string text = "abcdefghijklmnopqrstu";
+    for (std::size_t n = 0; n <= 20; ++n) {
+        const std::string literal = text.substr(0, n);
+        CHECK(parse(literal, lit_(literal) >> end_));
+        CHECK(parse(literal + "xyz", lit_(literal) >> lit_("xyz") >> end_));
+        for (std::size_t i = 0; i < n; ++i) {
+            std::string wrong = literal;
+            wrong[i] = '#';
+            CHECK(!parse(wrong, lit_(literal)));
+            CHECK(!parse(wrong + "padding to make it long", lit_(literal)));
+        }
+        if (n > 0) {
+            CHECK(!parse(literal.substr(0, n - 1), lit_(literal)));
+        }
+    }
+}
+
+TEST_CASE("test literals never read past the input"){
+    // the bytes after the input are the rest of the literal, so a
+    // read past the end would match
+    const std::string_view text = "abcdefghijklmnop";
+    for (std::size_t n = 1; n <= text.size(); ++n) {
+        std::unique_ptr<char[]> buffer(new char[n]);
+        std::memcpy(buffer.get(), text.data(), n);
+        const std::string_view input(buffer.get(), n);
+        const std::string_view cut = text.substr(0, n - 1);
+        CHECK(parse(input, lit_(text.substr(0, n)) >> end_));
+        CHECK(!parse(cut, lit_(text)));
+        CHECK(!parse(cut, ilit_(text)));
+        CHECK(!parse(cut, optimize(lit_(text) | lit_("abcz"))));
+        CHECK(!parse(input.substr(0, n - 1), lit_(text.substr(0, n))));
+    }
+}
+
+TEST_CASE("test case-insensitive literals"){
+    CHECK(parse("content-length", ilit_("Content-Length") >> end_));
+    CHECK(parse("CONTENT-LENGTH: 5", ilit_("Content-Length") >> char_(':')));
+    CHECK(parse("select", ilit_("SELECT") >> end_));
+    CHECK(parse("SeLeCt * FrOm t", ilit_("select") >> char_('*') >> ilit_("from") >> alpha_ >> end_));
+    CHECK(parse("a-very-long-header-name-x", ilit_("A-Very-Long-Header-Name-X") >> end_));
+    CHECK(!parse("content_length", ilit_("Content-Length")));
+    CHECK(!parse("content-lengt", ilit_("Content-Length")));
+    // only letters fold: '@' (0x40) must not match '`' (0x60)
+    CHECK(!parse("`", ilit_("@")));
+    CHECK(!parse("[", ilit_("{")));
+    CHECK(!parse("a-very-long-header-name_x", ilit_("A-Very-Long-Header-Name-X")));
+    CHECK(!parse("HTTP/1.1", lit_("http/")));
+}
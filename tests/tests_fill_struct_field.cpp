@@ -40,3 +40,41 @@ TEST_CASE("test fill struct field"){
 }
 
 
+
+TEST_CASE("test fill struct field after optimize"){
+    // the callbacks run the same way in the optimized grammar
+    CHECK(parse("aec abc", optimize(*(   ( (char_('a')[fa] >> char_('b')[fb])
+                            | (char_('a')[fa] >> char_('e')[fb]) )  >> char_('c')[fc] >> *space_)[fabc])));
+}
+
+TEST_CASE("test fill struct field with deferred callbacks"){
+    std::string calls;
+    std::function<void(const std::string_view&)> on_a = [&](const std::string_view& sv) { calls += "a"; };
+    std::function<void(const std::string_view&)> on_b = [&](const std::string_view& sv) { calls += "b"; };
+    std::function<void(const std::string_view&)> on_c = [&](const std::string_view& sv) { calls += "c"; };
+    std::function<void(const std::string_view&)> on_abc = [&](const std::string_view& sv) { calls += "|"; };
+    auto grammar = *(   ( (char_('a')[on_a] >> char_('b')[on_b])
+                        | (char_('a')[on_a] >> char_('e')[on_b]) )  >> char_('c')[on_c] >> *space_)[on_abc];
+
+    // right away, the first branch's 'a' is called for nothing on "aec"
+    CHECK(parse("aec abc", grammar));
+    CHECK(calls == "aabc|abc|");
+
+    // deferred, only the branches that made it into the match are called
+    calls.clear();
+    CHECK(parse_deferred("aec abc", grammar));
+    CHECK(calls == "abc|abc|");
+
+    // and nothing is called if the parse fails
+    calls.clear();
+    CHECK(!parse_deferred("aec abx", grammar >> end_));
+    CHECK(calls.empty());
+
+    // more callbacks than the inline buffer holds
+    std::string input;
+    for (int i = 0; i < 100; ++i)
+        input += "abc ";
+    calls.clear();
+    CHECK(parse_deferred(input, grammar >> end_));
+    CHECK(calls.size() == 400);
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Generates limn_utf8_tables.h from Python's unicodedata.
+
+Usage: python3 tools/gen_utf8_tables.py > limn_utf8_tables.h
+
+ID_Start and ID_Continue follow UAX #31, built from the general
+categories plus the Other_ID_Start / Other_ID_Continue code points,
+minus Pattern_Syntax and Pattern_White_Space.
+"""
+
+import sys
+import unicodedata
+
+OTHER_ID_START = {0x1885, 0x1886, 0x2118, 0x212E, 0x309B, 0x309C}
+OTHER_ID_CONTINUE = {0x00B7, 0x0387, 0x19DA, 0x200C, 0x200D, 0x30FB, 0xFF65} | set(range(0x1369, 0x1372))
+# the Pattern_Syntax / Pattern_White_Space code points that are letters or marks
+PATTERN = {0x2E2F}
+
+
+def ranges(pred):
+    out = []
+    for cp in range(0x110000):
+        if 0xD800 <= cp <= 0xDFFF or not pred(cp):
+            continue
+        if out and out[-1][1] == cp - 1:
+            out[-1][1] = cp
+        else:
+            out.append([cp, cp])
+    return out
+
+
+def category(cp):
+    return unicodedata.category(chr(cp))
+
+
+def is_letter(cp):
+    return category(cp).startswith('L')
+
+
+def is_id_start(cp):
+    if cp in PATTERN:
+        return False
+    return is_letter(cp) or category(cp) == 'Nl' or cp in OTHER_ID_START
+
+
+def is_id_continue(cp):
+    if cp in PATTERN:
+        return False
+    return is_id_start(cp) or category(cp) in ('Mn', 'Mc', 'Nd', 'Pc') or cp in OTHER_ID_CONTINUE
+
+
+def table(name, pred):
+    rs = ranges(pred)
+    lines = ['            inline constexpr range {}[] = {{'.format(name)]
+    for i in range(0, len(rs), 6):
+        row = ', '.join('{{0x{:x}, 0x{:x}}}'.format(lo, hi) for lo, hi in rs[i:i + 6])
+        lines.append('                ' + row + ',')
+    lines.append('            };')
+    return '\n'.join(lines)
+
+
+def main():
+    out = sys.stdout
+    out.write('/// @file limn_utf8_tables.h\n')
+    out.write('/// @brief Unicode {} code point tables for limn_utf8.h\n'.format(unicodedata.unidata_version))
+    out.write('/// @details Generated by tools/gen_utf8_tables.py, do not edit.\n\n')
+    out.write('#pragma once\n\n')
+    out.write('namespace lm {\n    namespace impl {\n        namespace unicode {\n')
+    out.write('            // sorted, non-overlapping, inclusive ranges\n')
+    out.write('            struct range {\n                char32_t lo;\n                char32_t hi;\n            };\n\n')
+    out.write(table('letter', is_letter) + '\n\n')
+    out.write(table('id_start', is_id_start) + '\n\n')
+    out.write(table('id_continue', is_id_continue) + '\n')
+    out.write('        }\n    }\n}\n')
+
+
+if __name__ == '__main__':
+    main()